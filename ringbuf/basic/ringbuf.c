@@ -1,3 +1,8 @@
+#define _GNU_SOURCE /* memfd_create */
+#include <sys/mman.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <errno.h>
 #include "ringbuf.h"
 
 ringbuf *ringbuf_new(size_t sz) {
@@ -9,15 +14,96 @@ ringbuf *ringbuf_new(size_t sz) {
 
   r->u = r->i = r->o = 0;
   r->n = sz;
+  r->f = 0;
 
  done:
   return r;
 }
 
+/* ringbuf_new_mirrored: alternative to ringbuf_new. the 
+ * ring's pages are mapped twice, back to back, so that 
+ * d[n+k] aliases d[k]. any pending or free region is then 
+ * one contiguous span, even when it wraps. sz is rounded 
+ * up to a multiple of the page size. free with ringbuf_free.
+ *
+ *  | hdr page | d (memfd pages) | d again (same pages) |
+ *         ^r   ^d
+ */
+ringbuf *ringbuf_new_mirrored(size_t sz) {
+  ringbuf *r = NULL;
+  char *base = MAP_FAILED, *d;
+  size_t pg = sysconf(_SC_PAGESIZE);
+  size_t hdr = offsetof(ringbuf, d);
+  int fd = -1;
+
+  assert(hdr <= pg);
+  assert(hdr % sizeof(size_t) == 0); /* r sits at d - hdr */
+  if (sz == 0) goto done;
+  sz = ((sz + pg - 1) / pg) * pg;
+
+  fd = memfd_create("ringbuf", MFD_CLOEXEC);
+  if (fd < 0) {
+    fprintf(stderr,"memfd_create: %s\n", strerror(errno));
+    goto done;
+  }
+  if (ftruncate(fd, sz) < 0) {
+    fprintf(stderr,"ftruncate: %s\n", strerror(errno));
+    goto done;
+  }
+
+  /* reserve the whole range, then map into it */
+  base = mmap(NULL, pg + 2*sz, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED) {
+    fprintf(stderr,"mmap: %s\n", strerror(errno));
+    goto done;
+  }
+  d = base + pg;
+  if ((mmap(base, pg, PROT_READ|PROT_WRITE, 
+            MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED, -1, 0) == MAP_FAILED) ||
+      (mmap(d, sz, PROT_READ|PROT_WRITE, 
+            MAP_SHARED|MAP_FIXED, fd, 0) == MAP_FAILED) ||
+      (mmap(d + sz, sz, PROT_READ|PROT_WRITE, 
+            MAP_SHARED|MAP_FIXED, fd, 0) == MAP_FAILED)) {
+    fprintf(stderr,"mmap: %s\n", strerror(errno));
+    munmap(base, pg + 2*sz);
+    goto done;
+  }
+
+  r = (ringbuf*)(d - hdr);
+  assert(r->d == d);
+  r->u = r->i = r->o = 0;
+  r->n = sz;
+  r->f = RINGBUF_MIRROR;
+
+ done:
+  if (fd != -1) close(fd);
+  return r;
+}
+
 void ringbuf_free(ringbuf* r) {
+  if (r->f & RINGBUF_MIRROR) {
+    size_t pg = sysconf(_SC_PAGESIZE);
+    munmap(r->d - pg, pg + 2*r->n);
+    return;
+  }
   free(r);
 }
 
+/* ringbuf_new_pow2: alternative to ringbuf_new. rounds 
+ * sz up to a power of two. i and o then run freely and
+ * are masked to get positions, so the hot path has no 
+ * division, and the used size is just i - o (u is not 
+ * kept). free with ringbuf_free.
+ */
+ringbuf *ringbuf_new_pow2(size_t sz) {
+  ringbuf *r;
+  size_t n = 1;
+  while (n < sz) n <<= 1;
+  r = ringbuf_new(n);
+  if (r) r->f = RINGBUF_POW2;
+  return r;
+}
+
 /* ringbuf_take: alternative to ringbuf_new; caller 
  * provides the buffer to use as the ringbuf.
  * buffer should be aligned e.g. from malloc/mmap.
@@ -30,47 +116,146 @@ ringbuf *ringbuf_take(void *buf, size_t sz) {
 
   r->u = r->i = r->o = 0;
   r->n = sz - sizeof(*r); // alignment should be ok
+  r->f = 0;
   assert(r->n > 0);
 
   return r;
 }
 
 
+/* index helpers. in a pow2 ring, i and o are free-running
+ * and masked to get positions; the used size is i - o. 
+ * otherwise i and o are positions and u is the used size;
+ * u is what tells an empty ring from a full one if i==o.
+ */
+#define POW2(r) ((r)->f & RINGBUF_POW2)
+static inline size_t ipos(ringbuf *r) {
+  return POW2(r) ? (r->i & (r->n - 1)) : r->i;
+}
+static inline size_t opos(ringbuf *r) {
+  return POW2(r) ? (r->o & (r->n - 1)) : r->o;
+}
+static inline size_t used(ringbuf *r) {
+  return POW2(r) ? (r->i - r->o) : r->u;
+}
+static inline void advance_i(ringbuf *r, size_t len) {
+  if (POW2(r)) { r->i += len; return; }
+  r->i = (r->i + len) % r->n;
+  r->u += len;
+}
+static inline void advance_o(ringbuf *r, size_t len) {
+  if (POW2(r)) { r->o += len; return; }
+  r->o = (r->o + len) % r->n;
+  r->u -= len;
+}
+/* move an empty ring's positions to the start of the
+ * buffer. in a pow2 ring the counts only ever grow, as a
+ * file-backed ring's recovery relies on, so they are 
+ * rounded up to the next multiple of n rather than zeroed */
+static inline void restart(ringbuf *r) {
+  if (POW2(r)) r->i = r->o = (r->i + r->n - 1) & ~(r->n - 1);
+  else r->i = r->o = 0;
+}
+
 /* copy data in. fails if ringbuf has insuff space. */
 #define MIN(a,b) (((a) < (b)) ? (a) : (b))
 int ringbuf_put(ringbuf *r, const void *_data, size_t len) {
   char *data = (char*)_data;
-  size_t a,b,c;
-  if (r->i < r->o) {  // available space is a contiguous buffer
-    a = r->o - r->i; 
-    assert(a == r->n - r->u);
-    if (len > a) return -1;
-    memcpy(&r->d[r->i], data, len);
-  } else {            // available space wraps; it's two buffers
-    b = r->n - r->i;  // in-head to eob (receives leading input)
-    c = r->o;         // out-head to in-head (receives trailing input)
-    a = b + c;        // available space
-    // the only ambiguous case is i==o, that's why u is needed
-    if (r->i == r->o) a = r->n - r->u; 
-    assert(a == r->n - r->u);
-    if (len > a) return -1;
-    memcpy(&r->d[r->i], data, MIN(b, len));
-    if (len > b) memcpy(r->d, &data[b], len-b);
+  size_t a,b,p;
+  a = r->n - used(r); // available space
+  if ((r->f & RINGBUF_OVERWRITE) && (len > a) && (len <= r->n)) {
+    ringbuf_mark_consumed(r, len - a); // evict oldest bytes
+    a = len;
   }
-  r->i = (r->i + len) % r->n;
-  r->u += len;
+  if (len > a) return -1;
+  // available space may wrap; if so it's two buffers. the
+  // part from in-head to eob receives the leading input.
+  // in a mirrored ring it never wraps.
+  p = ipos(r);
+  b = (r->f & RINGBUF_MIRROR) ? len : (r->n - p);
+  memcpy(&r->d[p], data, MIN(b, len));
+  if (len > b) memcpy(r->d, &data[b], len-b);
+  advance_i(r, len);
   return 0;
 }
 
+/* ringbuf_reserve: the producer-side counterpart to 
+ * ringbuf_get_next_chunk. it returns the size of the
+ * contiguous free space at the input position, putting
+ * its address in span, so the caller can write into the
+ * ring directly. it returns 0 (span NULL) unless at least 
+ * len bytes are contiguous; pass len 0 to take whatever
+ * is there. nothing is published until ringbuf_commit. 
+ */
+size_t ringbuf_reserve(ringbuf *r, size_t len, char **span) {
+  size_t a, u = used(r);
+  if (r->f & RINGBUF_MIRROR) a = r->n - u;
+  else if (ipos(r) < opos(r)) a = opos(r) - ipos(r);
+  else if (u == r->n) a = 0;
+  else {
+    a = r->n - ipos(r);  // in-head to eob
+    // an empty ring can restart at 0 to give the whole buffer
+    if ((a < len) && (u == 0)) { 
+      restart(r);
+      a = r->n;
+    }
+  }
+  if ((a == 0) || (a < len)) { *span = NULL; return 0; }
+  *span = &r->d[ipos(r)];
+  return a;
+}
+
+/* ringbuf_commit: publish len bytes written into the
+ * span from ringbuf_reserve. like ringbuf_mark_consumed
+ * but for the input position. */
+void ringbuf_commit(ringbuf *r, size_t len) {
+  assert(len <= r->n - used(r));
+  advance_i(r, len);
+}
+
+/* ringbuf_set_overwrite: in overwrite mode, a put that
+ * does not fit evicts the oldest data to make room, 
+ * rather than failing. ringbuf_put evicts bytes; the
+ * record mode puts evict whole records. a put larger
+ * than the ring still fails. */
+void ringbuf_set_overwrite(ringbuf *r, int on) {
+  if (on) r->f |= RINGBUF_OVERWRITE;
+  else r->f &= ~RINGBUF_OVERWRITE;
+}
+
+/* ringbuf_snapshot: copy out the newest len bytes of 
+ * pending data (or all of it, if less), without 
+ * consuming it. returns the number of bytes copied. */
+size_t ringbuf_snapshot(ringbuf *r, char *buf, size_t len) {
+  size_t c, p, b;
+  c = MIN(len, used(r));
+  p = (opos(r) + (used(r) - c)) % r->n; // start of newest c bytes
+  b = (r->f & RINGBUF_MIRROR) ? c : (r->n - p);
+  memcpy(buf, &r->d[p], MIN(b, c));
+  if (c > b) memcpy(&buf[b], r->d, c - b);
+  return c;
+}
+
 size_t ringbuf_get_freespace(ringbuf *r) {
-  return r->n - r->u;
+  return r->n - used(r);
 }
 
 size_t ringbuf_get_pending_size(ringbuf *r) {
-  return r->u;
+  return used(r);
 }
 
 size_t ringbuf_get_next_chunk(ringbuf *r, char **data) {
+  // in a mirrored ring the whole pending buffer is contiguous
+  if (r->f & RINGBUF_MIRROR) {
+    *data = used(r) ? &r->d[opos(r)] : NULL;
+    return used(r);
+  }
+  // in a pow2 ring i - o is the pending size; no ambiguity
+  if (POW2(r)) {
+    size_t u = r->i - r->o, p = opos(r);
+    *data = u ? &r->d[p] : NULL;
+    return MIN(u, r->n - p);
+  }
   // in this case the next chunk is the whole pending buffer
   if (r->o < r->i) {
     assert(r->u == r->i - r->o);
@@ -93,11 +278,222 @@ size_t ringbuf_get_next_chunk(ringbuf *r, char **data) {
 }
 
 void ringbuf_mark_consumed(ringbuf *r, size_t len) {
-  assert(len <= r->u);
-  r->o = (r->o + len ) % r->n;
-  r->u -= len;
+  assert(len <= used(r));
+  advance_o(r, len);
 }
 
+/* drop the pending data. a pow2 ring's counts only move 
+ * forward (see restart), so there o catches up with i */
 void ringbuf_clear(ringbuf *r) {
+  if (POW2(r)) { r->o = r->i; return; }
   r->u = r->i = r->o = 0;
 }
+
+/* ringbuf_read_fd: read from fd directly into the free 
+ * space of the ring, using one readv over the one or two
+ * free segments. returns the number of bytes read, 0 at
+ * eof, or -1 on error with errno set (EAGAIN if fd is
+ * non-blocking and has nothing; ENOBUFS if ring is full).
+ */
+ssize_t ringbuf_read_fd(ringbuf *r, int fd) {
+  struct iovec iov[2];
+  int iovcnt = 1;
+  ssize_t rc;
+
+  size_t a = r->n - used(r), p = ipos(r);
+
+  if (a == 0) { errno = ENOBUFS; return -1; }
+  iov[0].iov_base = &r->d[p];
+  iov[0].iov_len = (r->f & RINGBUF_MIRROR) ? a : MIN(a, r->n - p);
+  if (iov[0].iov_len < a) {
+    iov[1].iov_base = r->d;       // wrapped part
+    iov[1].iov_len = a - iov[0].iov_len;
+    iovcnt++;
+  }
+
+  rc = readv(fd, iov, iovcnt);
+  if (rc > 0) ringbuf_commit(r, rc);
+  return rc;
+}
+
+/* ringbuf_write_fd: write pending data from the ring to 
+ * fd, using one writev over the one or two pending 
+ * segments. the bytes written are marked consumed. 
+ * returns the number of bytes written (0 if the ring was
+ * empty), or -1 on error with errno set.
+ */
+ssize_t ringbuf_write_fd(ringbuf *r, int fd) {
+  struct iovec iov[2];
+  int iovcnt = 1;
+  ssize_t rc;
+
+  size_t u = used(r), p = opos(r);
+
+  if (u == 0) return 0;
+  iov[0].iov_base = &r->d[p];
+  iov[0].iov_len = (r->f & RINGBUF_MIRROR) ? u : MIN(u, r->n - p);
+  if (iov[0].iov_len < u) {
+    iov[1].iov_base = r->d;       // wrapped part
+    iov[1].iov_len = u - iov[0].iov_len;
+    iovcnt++;
+  }
+
+  rc = writev(fd, iov, iovcnt);
+  if (rc > 0) ringbuf_mark_consumed(r, rc);
+  return rc;
+}
+
+/* record mode
+ *
+ * a record is a u32 length header followed by its data.
+ * records are kept contiguous so they can be handed out
+ * as views into the ring. in a plain ring, a record that 
+ * would cross eob is placed at the start of the ring 
+ * instead; the space skipped at the end is marked by a 
+ * RINGBUF_MSG_WRAP header (or, if fewer than 4 bytes are
+ * left, skipped implicitly). skipped bytes count as used
+ * until the record after them is consumed. a mirrored 
+ * ring never needs to skip.
+ */
+
+/* bytes a record of len takes if put at the input 
+ * position, including any skip to the start of the ring;
+ * 0 if it does not fit. */
+static size_t msg_space(ringbuf *r, size_t len) {
+  size_t need = RINGBUF_MSG_HDR + len, tail, a = r->n - used(r);
+  if (need > a) {
+    return 0;
+  }
+  if ((r->f & RINGBUF_MIRROR) || (ipos(r) < opos(r))) {
+    return need; // free space is contiguous
+  }
+  tail = r->n - ipos(r); // in-head to eob
+  if (need <= tail) return need;
+  if (tail + need <= a) return tail + need;
+  // an empty ring can restart at 0 instead of skipping
+  if ((used(r) == 0) && (need <= r->n)) {
+    restart(r);
+    return need;
+  }
+  return 0;
+}
+
+/* in overwrite mode, drop oldest records until a record
+ * of len fits. returns the space it takes, or 0. */
+static size_t msg_evict(ringbuf *r, size_t len) {
+  struct iovec oldest;
+  size_t need, bytes;
+
+  need = msg_space(r, len);
+  if (need || !(r->f & RINGBUF_OVERWRITE)) return need;
+  if (RINGBUF_MSG_HDR + len > r->n) return 0;
+  while ((need = msg_space(r, len)) == 0) {
+    if (ringbuf_get_msgs(r, &oldest, 1, &bytes) == 0) break;
+    ringbuf_mark_consumed(r, bytes);
+  }
+  return need;
+}
+
+static void msg_copy_in(ringbuf *r, const void *data, size_t len) {
+  uint32_t hdr = len, wrap = RINGBUF_MSG_WRAP;
+  size_t p = ipos(r), tail = r->n - p;
+  if (!(r->f & RINGBUF_MIRROR) && (RINGBUF_MSG_HDR + len > tail)) {
+    if (tail >= RINGBUF_MSG_HDR) memcpy(&r->d[p], &wrap, sizeof(wrap));
+    advance_i(r, tail); // to start of ring
+    p = 0;
+  }
+  memcpy(&r->d[p], &hdr, sizeof(hdr));
+  memcpy(&r->d[p + RINGBUF_MSG_HDR], data, len);
+  advance_i(r, RINGBUF_MSG_HDR + len);
+}
+
+/* copy a record in. fails if ringbuf has insuff space. */
+int ringbuf_put_msg(ringbuf *r, const void *data, size_t len) {
+  if (len >= RINGBUF_MSG_WRAP) return -1;
+  if (msg_evict(r, len) == 0) return -1;
+  msg_copy_in(r, data, len);
+  return 0;
+}
+
+/* copy up to n records in. stops at the first record that
+ * does not fit. returns the number of records put. */
+size_t ringbuf_put_msgs(ringbuf *r, const struct iovec *msgs, size_t n) {
+  size_t k;
+  for(k=0; k < n; k++) {
+    if (msgs[k].iov_len >= RINGBUF_MSG_WRAP) break;
+    if (msg_evict(r, msgs[k].iov_len) == 0) break;
+    msg_copy_in(r, msgs[k].iov_base, msgs[k].iov_len);
+  }
+  return k;
+}
+
+/* walk to the next record from *pos, with *left pending
+ * bytes remaining. returns 0 if there are no more. */
+static int msg_next(ringbuf *r, size_t *pos, size_t *left, struct iovec *msg) {
+  size_t tail;
+  uint32_t hdr;
+
+  while (*left > 0) {
+    tail = r->n - *pos;
+    if (!(r->f & RINGBUF_MIRROR) && (tail < RINGBUF_MSG_HDR)) {
+      *pos = 0;
+      *left -= tail;
+      continue;
+    }
+    memcpy(&hdr, &r->d[*pos], sizeof(hdr));
+    if (hdr == RINGBUF_MSG_WRAP) {
+      assert(!(r->f & RINGBUF_MIRROR));
+      *pos = 0;
+      *left -= tail;
+      continue;
+    }
+    assert(RINGBUF_MSG_HDR + hdr <= *left);
+    msg->iov_base = &r->d[*pos + RINGBUF_MSG_HDR];
+    msg->iov_len = hdr;
+    *pos = (*pos + RINGBUF_MSG_HDR + hdr) % r->n;
+    *left -= RINGBUF_MSG_HDR + hdr;
+    return 1;
+  }
+  return 0;
+}
+
+/* get views of up to n pending records, without copying.
+ * returns the number of records, and puts the number of 
+ * ring bytes they span in *bytes. pass that to 
+ * ringbuf_mark_consumed when done with the records. */
+size_t ringbuf_get_msgs(ringbuf *r, struct iovec *msgs, size_t n, size_t *bytes) {
+  size_t pos = opos(r), left = used(r), k = 0;
+
+  while ((k < n) && msg_next(r, &pos, &left, &msgs[k])) k++;
+
+  *bytes = used(r) - left;
+  return k;
+}
+
+/* ringbuf_snapshot_msgs: copy out the newest whole records
+ * that fit in len bytes, oldest first, each still framed 
+ * by its u32 length, without consuming them. the skips at
+ * eob are left out. returns the number of bytes copied. */
+size_t ringbuf_snapshot_msgs(ringbuf *r, char *buf, size_t len) {
+  size_t pos = opos(r), left = used(r), total = 0, c = 0;
+  struct iovec msg;
+  uint32_t hdr;
+
+  /* framed size of every pending record */
+  while (msg_next(r, &pos, &left, &msg)) total += RINGBUF_MSG_HDR + msg.iov_len;
+
+  /* skip the oldest ones until the rest fit */
+  pos = opos(r); left = used(r);
+  while ((total > len) && msg_next(r, &pos, &left, &msg)) {
+    total -= RINGBUF_MSG_HDR + msg.iov_len;
+  }
+
+  while (msg_next(r, &pos, &left, &msg)) {
+    hdr = msg.iov_len;
+    memcpy(&buf[c], &hdr, sizeof(hdr));
+    memcpy(&buf[c + RINGBUF_MSG_HDR], msg.iov_base, msg.iov_len);
+    c += RINGBUF_MSG_HDR + msg.iov_len;
+  }
+  assert(c == total);
+  return c;
+}
@@ -4,25 +4,50 @@
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <stdint.h>
 
 /* simple ring buffer */
 
 typedef struct _ringbuf {
     size_t n; /* allocd size */
     size_t u; /* used space */
-    size_t i; /* input pos */
-    size_t o; /* output pos */
+    size_t i; /* input pos (count, if RINGBUF_POW2) */
+    size_t o; /* output pos (count, if RINGBUF_POW2) */
+    size_t f; /* flags; see below. size_t so d is aligned */
     char d[]; /* C99 flexible array member */
 } ringbuf;
 
+/* flags */
+#define RINGBUF_MIRROR 0x1 /* d is mapped twice back to back */
+#define RINGBUF_OVERWRITE 0x2 /* put evicts oldest data when full */
+#define RINGBUF_POW2 0x4 /* n is a power of two; i,o free-running */
+
 ringbuf *ringbuf_new(size_t sz);
+ringbuf *ringbuf_new_mirrored(size_t sz);
+ringbuf *ringbuf_new_pow2(size_t sz);
 ringbuf *ringbuf_take(void *buf, size_t sz);
 int ringbuf_put(ringbuf *r, const void *data, size_t len);
+size_t ringbuf_reserve(ringbuf *r, size_t len, char **span);
+void ringbuf_commit(ringbuf *r, size_t len);
 size_t ringbuf_get_pending_size(ringbuf *r);
 size_t ringbuf_get_next_chunk(ringbuf *r, char **data);
 void ringbuf_mark_consumed(ringbuf *r, size_t len);
 void ringbuf_free(ringbuf *r);
 void ringbuf_clear(ringbuf *r);
 size_t ringbuf_get_freespace(ringbuf *r);
+void ringbuf_set_overwrite(ringbuf *r, int on);
+size_t ringbuf_snapshot(ringbuf *r, char *buf, size_t len);
+ssize_t ringbuf_read_fd(ringbuf *r, int fd);
+ssize_t ringbuf_write_fd(ringbuf *r, int fd);
+
+/* record mode: each record is framed by a u32 length */
+#define RINGBUF_MSG_HDR sizeof(uint32_t)
+#define RINGBUF_MSG_WRAP ((uint32_t)-1) /* rest of ring is skipped */
+int ringbuf_put_msg(ringbuf *r, const void *data, size_t len);
+size_t ringbuf_put_msgs(ringbuf *r, const struct iovec *msgs, size_t n);
+size_t ringbuf_get_msgs(ringbuf *r, struct iovec *msgs, size_t n, size_t *bytes);
+size_t ringbuf_snapshot_msgs(ringbuf *r, char *buf, size_t len);
 
 #endif /* _RINGBUF_H_ */
@@ -0,0 +1,178 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <errno.h>
+#include "ringbuf_file.h"
+
+/* the live ring uses the pow2 layout. its i and o are 
+ * free-running, and each put or consume changes one of
+ * them with a single store, so a process that dies at 
+ * any point leaves the ring in the file consistent. */
+
+static uint32_t fnv1a(const void *_buf, size_t len) {
+  const unsigned char *buf = _buf;
+  uint32_t h = 2166136261U;
+  size_t k;
+  for(k=0; k < len; k++) h = (h ^ buf[k]) * 16777619U;
+  return h;
+}
+
+static void get_boot_id(char *boot, size_t len) {
+  ssize_t rc = -1;
+  int fd;
+  memset(boot, 0, len);
+  fd = open("/proc/sys/kernel/random/boot_id", O_RDONLY);
+  if (fd != -1) {
+    rc = read(fd, boot, len - 1);
+    close(fd);
+  }
+  if (rc <= 0) boot[0] = '\0';
+}
+
+#define slot(p,k) ((ringbuf_file_hdr*)((p)->m + (k) * RINGBUF_FILE_SLOT))
+
+static int slot_ok(ringbuf_file *p, int k) {
+  ringbuf_file_hdr *h = slot(p,k);
+  if (h->magic != RINGBUF_FILE_MAGIC) return 0;
+  if (h->version != RINGBUF_FILE_VERSION) return 0;
+  if (h->crc != fnv1a(h, offsetof(ringbuf_file_hdr, crc))) return 0;
+  if (h->n != p->r->n) return 0;
+  if (h->i - h->o > h->n) return 0;
+  return 1;
+}
+
+/* set the live indices from the newest valid commit */
+static void recover(ringbuf_file *p) {
+  ringbuf_file_hdr *h;
+  char boot[sizeof(h->boot)];
+  uint64_t i, o, li = p->r->i, lo = p->r->o;
+  int ok0 = slot_ok(p,0), ok1 = slot_ok(p,1);
+
+  p->r->u = 0;
+  p->r->f = RINGBUF_POW2;
+  if (!ok0 && !ok1) { /* new file, or nothing valid */
+    p->r->i = p->r->o = 0;
+    p->seq = 0;
+    return;
+  }
+  h = (ok0 && (!ok1 || slot(p,0)->seq > slot(p,1)->seq)) ? slot(p,0) : slot(p,1);
+  p->seq = h->seq;
+  i = h->i;
+  o = h->o;
+
+  /* same boot: the page cache kept every live update */
+  get_boot_id(boot, sizeof(boot));
+  if (boot[0] && !strcmp(boot, h->boot) && 
+      (li - i <= p->r->n) && (li - lo <= p->r->n)) {
+    i = li;
+  }
+  /* live o is a point we consumed to, if it's in range */
+  if (lo - o <= i - o) o = lo;
+
+  p->r->i = i;
+  p->r->o = o;
+}
+
+/* ringbuf_file_open: open or create the file at path. a
+ * new file gets a ring of sz bytes, rounded up to a power
+ * of two; an existing one keeps its own size, and its
+ * committed data is recovered. */
+ringbuf_file *ringbuf_file_open(const char *path, size_t sz) {
+  ringbuf_file *p = NULL;
+  struct stat st;
+  size_t n = 1;
+  int fd = -1;
+
+  while (n < sz) n <<= 1;
+
+  fd = open(path, O_RDWR|O_CREAT, 0644);
+  if (fd < 0) {
+    fprintf(stderr,"open %s: %s\n", path, strerror(errno));
+    goto done;
+  }
+  if (fstat(fd, &st) < 0) {
+    fprintf(stderr,"fstat %s: %s\n", path, strerror(errno));
+    goto done;
+  }
+  if (st.st_size == 0) {
+    st.st_size = RINGBUF_FILE_DATA + sizeof(ringbuf) + n;
+    if (ftruncate(fd, st.st_size) < 0) {
+      fprintf(stderr,"ftruncate %s: %s\n", path, strerror(errno));
+      goto done;
+    }
+  }
+  n = st.st_size - RINGBUF_FILE_DATA - sizeof(ringbuf);
+  if ((st.st_size <= (off_t)(RINGBUF_FILE_DATA + sizeof(ringbuf))) || (n & (n-1))) {
+    fprintf(stderr,"%s: not a ringbuf_file\n", path);
+    goto done;
+  }
+
+  p = calloc(1, sizeof(*p));
+  if (p == NULL) {
+    fprintf(stderr,"out of memory\n");
+    goto done;
+  }
+  p->map_sz = st.st_size;
+  p->m = mmap(NULL, p->map_sz, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p->m == MAP_FAILED) {
+    fprintf(stderr,"mmap %s: %s\n", path, strerror(errno));
+    free(p);
+    p = NULL;
+    goto done;
+  }
+  p->fd = fd;
+  fd = -1;
+
+  /* ringbuf_take would reset i and o; set up the fields 
+   * ourselves so the live indices can be recovered */
+  p->r = (ringbuf*)(p->m + RINGBUF_FILE_DATA);
+  p->r->n = n;
+  recover(p);
+  ringbuf_file_sync(p); /* commit under this boot id */
+
+ done:
+  if (fd != -1) close(fd);
+  return p;
+}
+
+/* ringbuf_file_sync: group commit. flush the ring data, 
+ * then write the indices to the older header slot and 
+ * flush it. returns 0, or -1 on error (errno set). 
+ * (msync wants page alignment, so the first flush takes
+ * the header page along; that is harmless, as the slot 
+ * it holds is not the one being written) */
+int ringbuf_file_sync(ringbuf_file *p) {
+  ringbuf_file_hdr *h;
+
+  if (msync(p->m, p->map_sz, MS_SYNC) < 0) {
+    fprintf(stderr,"msync: %s\n", strerror(errno));
+    return -1;
+  }
+
+  p->seq++;
+  h = slot(p, p->seq % 2);
+  memset(h, 0, sizeof(*h));
+  h->magic = RINGBUF_FILE_MAGIC;
+  h->version = RINGBUF_FILE_VERSION;
+  h->seq = p->seq;
+  h->n = p->r->n;
+  h->i = p->r->i;
+  h->o = p->r->o;
+  get_boot_id(h->boot, sizeof(h->boot));
+  h->crc = fnv1a(h, offsetof(ringbuf_file_hdr, crc));
+
+  if (msync(p->m, RINGBUF_FILE_DATA, MS_SYNC) < 0) {
+    fprintf(stderr,"msync: %s\n", strerror(errno));
+    return -1;
+  }
+  return 0;
+}
+
+void ringbuf_file_close(ringbuf_file *p) {
+  ringbuf_file_sync(p);
+  munmap(p->m, p->map_sz);
+  close(p->fd);
+  free(p);
+}
@@ -0,0 +1,48 @@
+#ifndef _RINGBUF_FILE_H_
+#define _RINGBUF_FILE_H_
+#include <stdint.h>
+#include "ringbuf.h"
+
+/* ringbuf persisted in a file that survives a restart.
+ * the file is mmap'd and the ring is placed in it with 
+ * ringbuf_take; use the ordinary ringbuf calls on ->r.
+ * ringbuf_file_sync is a group commit: it msyncs the 
+ * data, then writes the indices into a checksummed 
+ * header. call it after a batch of puts, or on a timer,
+ * rather than after every put.
+ *
+ * on reopen the committed region is recovered. data put
+ * after the last sync is kept too if the machine did not
+ * reboot in between (the page cache still has it). data
+ * already consumed is not handed out again.
+ */
+
+#define RINGBUF_FILE_MAGIC 0x46425252 /* "RRBF" */
+#define RINGBUF_FILE_VERSION 2
+#define RINGBUF_FILE_SLOT 512  /* header slots are sector aligned */
+#define RINGBUF_FILE_DATA (2*RINGBUF_FILE_SLOT)
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t seq;     /* commit number; newest valid slot wins */
+  uint64_t n;       /* ring size */
+  uint64_t i;       /* committed input count */
+  uint64_t o;       /* committed output count */
+  char boot[40];    /* boot id at commit */
+  uint32_t crc;     /* checksum of the above */
+} ringbuf_file_hdr;
+
+typedef struct {
+  char *m;          /* the mapping: 2 header slots, then ring */
+  size_t map_sz;
+  uint64_t seq;
+  ringbuf *r;
+  int fd;
+} ringbuf_file;
+
+ringbuf_file *ringbuf_file_open(const char *path, size_t sz);
+int ringbuf_file_sync(ringbuf_file *p);
+void ringbuf_file_close(ringbuf_file *p);
+
+#endif /* _RINGBUF_FILE_H_ */
@@ -0,0 +1,99 @@
+#include <stdint.h>
+#include "ringbuf_mpmc.h"
+
+#define LOAD(p)        __atomic_load_n((p), __ATOMIC_RELAXED)
+#define LOAD_ACQ(p)    __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_REL(p,v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define CAS(p,e,v)     __atomic_compare_exchange_n((p), (e), (v), 1, \
+                         __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#define MIN(a,b) (((a) < (b)) ? (a) : (b))
+
+#define cell(q,pos) ((ringbuf_mpmc_cell*)((q)->cells + ((pos) & (q)->mask) * (q)->stride))
+
+/* nmsgs is rounded up to a power of two */
+ringbuf_mpmc *ringbuf_mpmc_new(size_t nmsgs, size_t max_msg) {
+  ringbuf_mpmc *q = NULL;
+  size_t n = 2, i;
+
+  while (n < nmsgs) n <<= 1;
+  if (posix_memalign((void**)&q, RINGBUF_CACHELINE, sizeof(*q))) {
+    fprintf(stderr,"out of memory\n");
+    q = NULL;
+    goto done;
+  }
+  q->mask = n - 1;
+  q->max_msg = max_msg;
+  q->stride = (sizeof(ringbuf_mpmc_cell) + max_msg + 7) & ~(size_t)7;
+  if (posix_memalign((void**)&q->cells, RINGBUF_CACHELINE, n * q->stride)) {
+    fprintf(stderr,"out of memory\n");
+    free(q);
+    q = NULL;
+    goto done;
+  }
+  for(i=0; i < n; i++) cell(q,i)->seq = i;
+  q->e = q->d = 0;
+
+ done:
+  return q;
+}
+
+void ringbuf_mpmc_free(ringbuf_mpmc *q) {
+  free(q->cells);
+  free(q);
+}
+
+/* copy a record in. fails if the queue is full or if
+ * len exceeds max_msg. */
+int ringbuf_mpmc_put(ringbuf_mpmc *q, const void *data, size_t len) {
+  ringbuf_mpmc_cell *c;
+  size_t pos, seq;
+  intptr_t dif;
+
+  if (len > q->max_msg) return -1;
+  pos = LOAD(&q->e);
+  for(;;) {
+    c = cell(q,pos);
+    seq = LOAD_ACQ(&c->seq);
+    dif = (intptr_t)seq - (intptr_t)pos;
+    if (dif == 0) {           /* cell is free for pos */
+      if (CAS(&q->e, &pos, pos + 1)) break;
+    } else if (dif < 0) {     /* cell not consumed yet */
+      return -1;
+    } else {                  /* another producer got it */
+      pos = LOAD(&q->e);
+    }
+  }
+
+  c->len = len;
+  memcpy(c->data, data, len);
+  STORE_REL(&c->seq, pos + 1);
+  return 0;
+}
+
+/* copy the oldest record out, up to len bytes of it. 
+ * returns its length, or -1 if the queue is empty. */
+ssize_t ringbuf_mpmc_get(ringbuf_mpmc *q, void *buf, size_t len) {
+  ringbuf_mpmc_cell *c;
+  size_t pos, seq;
+  intptr_t dif;
+  ssize_t rc;
+
+  pos = LOAD(&q->d);
+  for(;;) {
+    c = cell(q,pos);
+    seq = LOAD_ACQ(&c->seq);
+    dif = (intptr_t)seq - (intptr_t)(pos + 1);
+    if (dif == 0) {           /* cell holds the record for pos */
+      if (CAS(&q->d, &pos, pos + 1)) break;
+    } else if (dif < 0) {     /* not put yet */
+      return -1;
+    } else {                  /* another consumer got it */
+      pos = LOAD(&q->d);
+    }
+  }
+
+  rc = c->len;
+  memcpy(buf, c->data, MIN(len, c->len));
+  STORE_REL(&c->seq, pos + q->mask + 1);
+  return rc;
+}
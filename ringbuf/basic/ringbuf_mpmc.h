@@ -0,0 +1,41 @@
+#ifndef _RINGBUF_MPMC_H_
+#define _RINGBUF_MPMC_H_
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <sys/types.h>
+#include "ringbuf_spsc.h" /* RINGBUF_CACHELINE */
+
+/* bounded queue of records for any number of producer 
+ * and consumer threads (Vyukov's bounded MPMC queue).
+ * the ring is an array of cells, each holding one record
+ * of up to max_msg bytes, and a sequence number. a thread
+ * claims a cell by CAS on the enqueue or dequeue position
+ * once the cell's sequence says it is its turn; it then
+ * publishes the cell by a release store of its sequence.
+ * producers and consumers only contend among themselves,
+ * and never on the same cell at the same time.
+ */
+
+typedef struct {
+    size_t seq;
+    size_t len;
+    char data[];
+} ringbuf_mpmc_cell;
+
+typedef struct _ringbuf_mpmc {
+    size_t mask;    /* number of cells - 1 */
+    size_t max_msg; /* record capacity of a cell */
+    size_t stride;  /* bytes per cell */
+    char *cells;
+    size_t e  __attribute__((aligned(RINGBUF_CACHELINE))); /* enqueue pos */
+    size_t d  __attribute__((aligned(RINGBUF_CACHELINE))); /* dequeue pos */
+} ringbuf_mpmc;
+
+ringbuf_mpmc *ringbuf_mpmc_new(size_t nmsgs, size_t max_msg);
+void ringbuf_mpmc_free(ringbuf_mpmc *q);
+int ringbuf_mpmc_put(ringbuf_mpmc *q, const void *data, size_t len);
+ssize_t ringbuf_mpmc_get(ringbuf_mpmc *q, void *buf, size_t len);
+
+#endif /* _RINGBUF_MPMC_H_ */
@@ -0,0 +1,255 @@
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <linux/futex.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include "ringbuf_shm.h"
+
+static int futex_wait(uint32_t *addr, uint32_t val) {
+  return syscall(SYS_futex, addr, FUTEX_WAIT, val, NULL, NULL, 0);
+}
+
+static int futex_wake(uint32_t *addr, int n) {
+  return syscall(SYS_futex, addr, FUTEX_WAKE, n, NULL, NULL, 0);
+}
+
+/* a dead process may have held the lock mid-update; its
+ * put or consume is lost. if the indices it left do not
+ * agree the pending data can't be trusted, so drop it. */
+static void shm_repair(ringbuf *r) {
+  if ((r->i >= r->n) || (r->o >= r->n) || (r->u > r->n) ||
+      ((r->o + r->u) % r->n != r->i)) {
+    fprintf(stderr,"ringbuf_shm: lock owner died; ring reset\n");
+    ringbuf_clear(r);
+  }
+}
+
+/* the lock is a robust, process-shared mutex, so if its 
+ * owner dies holding it the next locker gets EOWNERDEAD
+ * instead of hanging, and repairs the ring. */
+static void shm_lock(ringbuf_shm *s) {
+  int rc = pthread_mutex_lock(&s->h->lock);
+  if (rc == EOWNERDEAD) {
+    shm_repair(s->r);
+    pthread_mutex_consistent(&s->h->lock);
+  } else assert(rc == 0);
+}
+
+static void shm_unlock(ringbuf_shm *s) {
+  pthread_mutex_unlock(&s->h->lock);
+}
+
+/* sleep until *seq changes from the value seen under the
+ * lock. called and returns with the lock held. */
+static void shm_wait(ringbuf_shm *s, uint32_t *seq, uint32_t *nwait) {
+  uint32_t v = *seq;
+  (*nwait)++;
+  shm_unlock(s);
+  futex_wait(seq, v);
+  shm_lock(s);
+  (*nwait)--;
+}
+
+static ringbuf_shm *shm_map(int fd, size_t sz) {
+  ringbuf_shm *s = NULL;
+  void *m;
+  int flags = (fd == -1) ? (MAP_SHARED|MAP_ANONYMOUS) : MAP_SHARED;
+
+  m = mmap(NULL, sz, PROT_READ|PROT_WRITE, flags, fd, 0);
+  if (m == MAP_FAILED) {
+    fprintf(stderr,"mmap: %s\n", strerror(errno));
+    goto done;
+  }
+  s = calloc(1, sizeof(*s));
+  if (s == NULL) {
+    fprintf(stderr,"out of memory\n");
+    munmap(m, sz);
+    goto done;
+  }
+  s->h = m;
+  s->r = (ringbuf*)s->h->ring;
+  s->efd = -1;
+
+ done:
+  return s;
+}
+
+/* ringbuf_shm_create: make a shared ring of sz bytes in
+ * total (header included). if name is NULL, the mapping 
+ * is anonymous; it can be shared with children that are 
+ * forked afterward. otherwise name is a shm_open name 
+ * like "/myring" that other processes can attach to. 
+ */
+ringbuf_shm *ringbuf_shm_create(const char *name, size_t sz, int flags) {
+  ringbuf_shm *s = NULL;
+  pthread_mutexattr_t ma;
+  int fd = -1;
+
+  if (sz <= sizeof(ringbuf_shm_hdr) + sizeof(ringbuf)) goto done;
+
+  if (name) {
+    fd = shm_open(name, O_RDWR|O_CREAT|O_TRUNC, 0600);
+    if (fd < 0) {
+      fprintf(stderr,"shm_open %s: %s\n", name, strerror(errno));
+      goto done;
+    }
+    if (ftruncate(fd, sz) < 0) {
+      fprintf(stderr,"ftruncate: %s\n", strerror(errno));
+      goto done;
+    }
+  }
+
+  s = shm_map(fd, sz);
+  if (s == NULL) goto done;
+  memset(s->h, 0, sizeof(ringbuf_shm_hdr));
+  s->h->sz = sz;
+  pthread_mutexattr_init(&ma);
+  pthread_mutexattr_setpshared(&ma, PTHREAD_PROCESS_SHARED);
+  pthread_mutexattr_setrobust(&ma, PTHREAD_MUTEX_ROBUST);
+  pthread_mutex_init(&s->h->lock, &ma);
+  pthread_mutexattr_destroy(&ma);
+  s->r = ringbuf_take(s->h->ring, sz - sizeof(ringbuf_shm_hdr));
+  assert(s->r);
+
+  if (flags & RINGBUF_SHM_EVENTFD) {
+    s->efd = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+    if (s->efd < 0) {
+      fprintf(stderr,"eventfd: %s\n", strerror(errno));
+      ringbuf_shm_close(s);
+      s = NULL;
+      goto done;
+    }
+    s->h->flags |= RINGBUF_SHM_EVENTFD;
+  }
+
+ done:
+  if (fd != -1) close(fd);
+  return s;
+}
+
+/* ringbuf_shm_attach: map a ring made by ringbuf_shm_create
+ * in another process. the eventfd is not shared this way, 
+ * so a ring that has one can't be attached: puts from here
+ * would never wake its epoll waiters. */
+ringbuf_shm *ringbuf_shm_attach(const char *name) {
+  ringbuf_shm *s = NULL;
+  struct stat st;
+  int fd = -1;
+
+  fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0) {
+    fprintf(stderr,"shm_open %s: %s\n", name, strerror(errno));
+    goto done;
+  }
+  if (fstat(fd, &st) < 0) {
+    fprintf(stderr,"fstat: %s\n", strerror(errno));
+    goto done;
+  }
+  if ((size_t)st.st_size <= sizeof(ringbuf_shm_hdr) + sizeof(ringbuf)) {
+    fprintf(stderr,"%s: not a ringbuf_shm\n", name);
+    goto done;
+  }
+
+  s = shm_map(fd, st.st_size);
+  if (s && (s->h->flags & RINGBUF_SHM_EVENTFD)) {
+    fprintf(stderr,"%s: has an eventfd; attach would not signal it\n", name);
+    munmap(s->h, st.st_size);
+    free(s);
+    s = NULL;
+  }
+
+ done:
+  if (fd != -1) close(fd);
+  return s;
+}
+
+void ringbuf_shm_close(ringbuf_shm *s) {
+  if (s->efd != -1) close(s->efd);
+  munmap(s->h, s->h->sz);
+  free(s);
+}
+
+int ringbuf_shm_unlink(const char *name) {
+  return shm_unlink(name);
+}
+
+/* for epoll. it becomes readable when the ring goes from
+ * empty to non-empty. when it is, read its 8 byte count 
+ * to reset it, then drain the ring until
+ * ringbuf_shm_get_next_chunk returns 0. */
+int ringbuf_shm_get_eventfd(ringbuf_shm *s) {
+  return s->efd;
+}
+
+/* copy data in. if wait is non-zero, sleeps until there 
+ * is room; otherwise fails if ringbuf has insuff space. */
+int ringbuf_shm_put(ringbuf_shm *s, const void *data, size_t len, int wait) {
+  ringbuf_shm_hdr *h = s->h;
+  uint64_t one = 1;
+  uint32_t w;
+  size_t u;
+  int rc;
+
+  if (len > s->r->n) return -1;
+
+  shm_lock(s);
+  while (((rc = ringbuf_put(s->r, data, len)) < 0) && wait) {
+    shm_wait(s, &h->cseq, &h->cwait);
+  }
+  u = s->r->u;
+  if (rc == 0) h->pseq++;
+  w = h->pwait;
+  shm_unlock(s);
+
+  if (rc < 0) return -1;
+  if (w) futex_wake(&h->pseq, INT_MAX);
+  if ((s->efd != -1) && (u == len)) { /* was empty */
+    if (write(s->efd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+      fprintf(stderr,"eventfd write: %s\n", strerror(errno));
+    }
+  }
+  return 0;
+}
+
+size_t ringbuf_shm_get_pending_size(ringbuf_shm *s) {
+  size_t u;
+  shm_lock(s);
+  u = ringbuf_get_pending_size(s->r);
+  shm_unlock(s);
+  return u;
+}
+
+/* like ringbuf_get_next_chunk. if wait is non-zero, sleeps
+ * until there is pending data. the chunk stays valid 
+ * until it is marked consumed, since producers only 
+ * write into free space. */
+size_t ringbuf_shm_get_next_chunk(ringbuf_shm *s, char **data, int wait) {
+  ringbuf_shm_hdr *h = s->h;
+  size_t sz;
+
+  shm_lock(s);
+  while ((s->r->u == 0) && wait) {
+    shm_wait(s, &h->pseq, &h->pwait);
+  }
+  sz = ringbuf_get_next_chunk(s->r, data);
+  shm_unlock(s);
+  return sz;
+}
+
+void ringbuf_shm_mark_consumed(ringbuf_shm *s, size_t len) {
+  ringbuf_shm_hdr *h = s->h;
+  uint32_t w;
+
+  shm_lock(s);
+  ringbuf_mark_consumed(s->r, len);
+  h->cseq++;
+  w = h->cwait;
+  shm_unlock(s);
+
+  if (w) futex_wake(&h->cseq, INT_MAX);
+}
@@ -0,0 +1,57 @@
+#ifndef _RINGBUF_SHM_H_
+#define _RINGBUF_SHM_H_
+#include <stdint.h>
+#include <pthread.h>
+#include "ringbuf.h"
+
+/* ringbuf shared between processes. the header and the 
+ * ring (placed with ringbuf_take) live in one shared 
+ * mapping, from shm_open or an anonymous shared mapping
+ * inherited across fork. a robust process-shared mutex
+ * guards the ring's indices; callers that wait sleep on a
+ * futex sequence word rather than spinning. wakeups are 
+ * only issued when a waiter is recorded, so an uncontended
+ * put or consume makes no system call.
+ *
+ * if a process dies holding the lock, the next locker
+ * takes it over. a put or consume the dead process was in
+ * the middle of is lost, and if it left the indices torn,
+ * the pending data is dropped (the ring is cleared).
+ */
+
+typedef struct {
+  pthread_mutex_t lock; /* robust, process-shared */
+  uint32_t pseq;    /* futex: bumped when data is put */
+  uint32_t cseq;    /* futex: bumped when data is consumed */
+  uint32_t pwait;   /* number sleeping on pseq (consumers) */
+  uint32_t cwait;   /* number sleeping on cseq (producers) */
+  uint32_t flags;   /* RINGBUF_SHM_EVENTFD if the creator has one */
+  size_t sz;        /* size of the whole mapping */
+  char ring[];      /* ringbuf_take'n */
+} ringbuf_shm_hdr;
+
+typedef struct {
+  ringbuf_shm_hdr *h;
+  ringbuf *r;
+  int efd;          /* eventfd or -1 */
+} ringbuf_shm;
+
+/* flags */
+#define RINGBUF_SHM_EVENTFD 0x1 /* signal an eventfd on empty->non-empty */
+
+/* an eventfd is only inherited across fork. ringbuf_shm_attach
+ * fails on a ring made with RINGBUF_SHM_EVENTFD, since puts from
+ * the attached process could not signal it. */
+
+ringbuf_shm *ringbuf_shm_create(const char *name, size_t sz, int flags);
+ringbuf_shm *ringbuf_shm_attach(const char *name);
+void ringbuf_shm_close(ringbuf_shm *s);
+int ringbuf_shm_unlink(const char *name);
+int ringbuf_shm_get_eventfd(ringbuf_shm *s);
+
+int ringbuf_shm_put(ringbuf_shm *s, const void *data, size_t len, int wait);
+size_t ringbuf_shm_get_pending_size(ringbuf_shm *s);
+size_t ringbuf_shm_get_next_chunk(ringbuf_shm *s, char **data, int wait);
+void ringbuf_shm_mark_consumed(ringbuf_shm *s, size_t len);
+
+#endif /* _RINGBUF_SHM_H_ */
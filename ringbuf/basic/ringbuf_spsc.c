@@ -0,0 +1,84 @@
+#include "ringbuf_spsc.h"
+
+#define LOAD_ACQ(p)    __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define STORE_REL(p,v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define MIN(a,b) (((a) < (b)) ? (a) : (b))
+
+ringbuf_spsc *ringbuf_spsc_new(size_t sz) {
+  ringbuf_spsc *r = NULL;
+  if (sz == 0) goto done;
+  if (posix_memalign((void**)&r, RINGBUF_CACHELINE, sizeof(*r) + sz)) {
+    fprintf(stderr,"out of memory\n");
+    r = NULL;
+    goto done;
+  }
+
+  r->i = r->oc = r->o = r->ic = 0;
+  r->n = sz;
+
+ done:
+  return r;
+}
+
+void ringbuf_spsc_free(ringbuf_spsc *r) {
+  free(r);
+}
+
+/* copy data in. fails if ringbuf has insuff space. 
+ * the consumer's o is only re-read when the cached
+ * copy says there is not enough room. */
+int ringbuf_spsc_put(ringbuf_spsc *r, const void *_data, size_t len) {
+  char *data = (char*)_data;
+  size_t i = r->i; /* only we write it */
+  size_t a, p, b;
+
+  a = r->n - (i - r->oc);
+  if (len > a) {
+    r->oc = LOAD_ACQ(&r->o);
+    a = r->n - (i - r->oc);
+    if (len > a) return -1;
+  }
+
+  p = i % r->n;
+  b = r->n - p;    /* in-head to eob */
+  memcpy(&r->d[p], data, MIN(b, len));
+  if (len > b) memcpy(r->d, &data[b], len-b);
+
+  STORE_REL(&r->i, i + len);
+  return 0;
+}
+
+size_t ringbuf_spsc_get_freespace(ringbuf_spsc *r) {
+  r->oc = LOAD_ACQ(&r->o);
+  return r->n - (r->i - r->oc);
+}
+
+size_t ringbuf_spsc_get_pending_size(ringbuf_spsc *r) {
+  r->ic = LOAD_ACQ(&r->i);
+  return r->ic - r->o;
+}
+
+/* like ringbuf_get_next_chunk: if the pending data wraps,
+ * this returns the part before eob; the next call (after
+ * marking it consumed) gets the wrapped part. */
+size_t ringbuf_spsc_get_next_chunk(ringbuf_spsc *r, char **data) {
+  size_t o = r->o; /* only we write it */
+  size_t u, p, b;
+
+  u = r->ic - o;
+  if (u == 0) {
+    r->ic = LOAD_ACQ(&r->i);
+    u = r->ic - o;
+    if (u == 0) { *data = NULL; return 0; }
+  }
+
+  p = o % r->n;
+  b = r->n - p;    /* out-head to eob */
+  *data = &r->d[p];
+  return MIN(b, u);
+}
+
+void ringbuf_spsc_mark_consumed(ringbuf_spsc *r, size_t len) {
+  assert(len <= r->ic - r->o);
+  STORE_REL(&r->o, r->o + len);
+}
@@ -0,0 +1,44 @@
+#ifndef _RINGBUF_SPSC_H_
+#define _RINGBUF_SPSC_H_
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+
+/* lock-free ring buffer for exactly one producer thread 
+ * and one consumer thread. the producer only writes i;
+ * the consumer only writes o. each is published with a
+ * release store and read with an acquire load. they sit
+ * on separate cache lines so the two threads do not
+ * contend on the same line for every call.
+ *
+ * i and o are free-running byte counts; the position in
+ * d is the count modulo n, and i - o is the pending size.
+ */
+
+#define RINGBUF_CACHELINE 64
+
+typedef struct _ringbuf_spsc {
+    size_t n;  /* allocd size */
+    /* producer side */
+    size_t i  __attribute__((aligned(RINGBUF_CACHELINE))); /* input count */
+    size_t oc; /* producer's cached copy of o */
+    /* consumer side */
+    size_t o  __attribute__((aligned(RINGBUF_CACHELINE))); /* output count */
+    size_t ic; /* consumer's cached copy of i */
+    char d[]  __attribute__((aligned(RINGBUF_CACHELINE)));
+} ringbuf_spsc;
+
+ringbuf_spsc *ringbuf_spsc_new(size_t sz);
+void ringbuf_spsc_free(ringbuf_spsc *r);
+
+/* producer thread only */
+int ringbuf_spsc_put(ringbuf_spsc *r, const void *data, size_t len);
+size_t ringbuf_spsc_get_freespace(ringbuf_spsc *r);
+
+/* consumer thread only */
+size_t ringbuf_spsc_get_pending_size(ringbuf_spsc *r);
+size_t ringbuf_spsc_get_next_chunk(ringbuf_spsc *r, char **data);
+void ringbuf_spsc_mark_consumed(ringbuf_spsc *r, size_t len);
+
+#endif /* _RINGBUF_SPSC_H_ */
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ringbuf.h"
+
+/* compares ringbuf_new to ringbuf_new_mirrored for a 
+ * producer/parser loop. the parser needs each record
+ * contiguous; with ringbuf_new a wrapped record has to
+ * be copied to a scratch buffer first.
+ *
+ * usage: bench_mirror [total-mb] [ring-sz]
+ */
+
+size_t total = 1024UL * 1024 * 1024;
+size_t ring_sz = 1024 * 1024;
+
+unsigned long parse(char *rec, size_t len) {
+  unsigned long sum = 0;
+  size_t k;
+  for(k=0; k < len; k += 64) sum += rec[k];
+  return sum;
+}
+
+double run(ringbuf *r, size_t rec_sz, unsigned long *sum) {
+  struct timespec a, b;
+  char *rec, *scratch, *d;
+  size_t i, sz;
+
+  rec = calloc(1, rec_sz);
+  scratch = malloc(rec_sz);
+  if ((rec == NULL) || (scratch == NULL)) exit(-1);
+
+  clock_gettime(CLOCK_MONOTONIC, &a);
+  for(i=0; i < total; i += rec_sz) {
+    if (ringbuf_put(r, rec, rec_sz) < 0) exit(-1);
+    sz = ringbuf_get_next_chunk(r, &d);
+    if (sz < rec_sz) { /* wrapped; reassemble */
+      memcpy(scratch, d, sz);
+      ringbuf_mark_consumed(r, sz);
+      ringbuf_get_next_chunk(r, &d);
+      memcpy(&scratch[sz], d, rec_sz - sz);
+      ringbuf_mark_consumed(r, rec_sz - sz);
+      *sum += parse(scratch, rec_sz);
+    } else {
+      *sum += parse(d, rec_sz);
+      ringbuf_mark_consumed(r, rec_sz);
+    }
+  }
+  clock_gettime(CLOCK_MONOTONIC, &b);
+
+  free(rec);
+  free(scratch);
+  return (b.tv_sec - a.tv_sec) + (b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+  ringbuf *r, *m;
+  unsigned long sum = 0;
+  double r_s, m_s, mb;
+  size_t rec_sz;
+
+  if (argc > 1) total = strtoul(argv[1], NULL, 10) * 1024 * 1024;
+  if (argc > 2) ring_sz = strtoul(argv[2], NULL, 10);
+
+  m = ringbuf_new_mirrored(ring_sz);
+  if (m == NULL) return -1;
+  r = ringbuf_new(m->n);
+  if (r == NULL) return -1;
+  mb = total / (1024.0 * 1024);
+
+  printf("%lu MB through a %lu byte ring\n", (unsigned long)mb, m->n);
+  printf("%8s %14s %14s\n", "rec_sz", "plain MB/s", "mirror MB/s");
+  /* records are one byte short so they do not divide the ring evenly */
+  for(rec_sz = 64; rec_sz <= 64 * 1024; rec_sz *= 2) {
+    r_s = run(r, rec_sz - 1, &sum);
+    m_s = run(m, rec_sz - 1, &sum);
+    printf("%8lu %14.0f %14.0f\n", rec_sz, mb / r_s, mb / m_s);
+  }
+
+  ringbuf_free(r);
+  ringbuf_free(m);
+  return (sum == 1); /* keep parse from being optimized out */
+}
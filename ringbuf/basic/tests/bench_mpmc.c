@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "ringbuf.h"
+#include "ringbuf_mpmc.h"
+
+/* records/sec through one queue shared by 1, 2, 4, 8 and
+ * 16 producer/consumer thread pairs, comparing a mutex-
+ * wrapped ringbuf (in record mode) to ringbuf_mpmc.
+ *
+ * usage: bench_mpmc [million-recs] [rec-sz]
+ */
+
+size_t total = 4UL * 1000 * 1000;
+size_t rec_sz = 64;
+size_t per_producer;
+size_t received;
+
+ringbuf *rb;
+pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
+ringbuf_mpmc *q;
+
+void *mtx_produce(void *arg) {
+  char rec[256] = {0};
+  size_t i=0;
+  int rc;
+  (void)arg;
+  while(i < per_producer) {
+    pthread_mutex_lock(&mtx);
+    rc = ringbuf_put_msg(rb, rec, rec_sz);
+    pthread_mutex_unlock(&mtx);
+    if (rc == 0) i++;
+    else sched_yield();
+  }
+  return NULL;
+}
+
+void *mtx_consume(void *arg) {
+  char rec[256];
+  struct iovec msg;
+  size_t n, bytes;
+  (void)arg;
+  while (__atomic_load_n(&received, __ATOMIC_RELAXED) < total) {
+    pthread_mutex_lock(&mtx);
+    n = ringbuf_get_msgs(rb, &msg, 1, &bytes);
+    if (n) {
+      memcpy(rec, msg.iov_base, msg.iov_len);
+      ringbuf_mark_consumed(rb, bytes);
+    }
+    pthread_mutex_unlock(&mtx);
+    if (n) __atomic_add_fetch(&received, 1, __ATOMIC_RELAXED);
+    else sched_yield();
+  }
+  return NULL;
+}
+
+void *mpmc_produce(void *arg) {
+  char rec[256] = {0};
+  size_t i=0;
+  (void)arg;
+  while(i < per_producer) {
+    if (ringbuf_mpmc_put(q, rec, rec_sz) == 0) i++;
+    else sched_yield();
+  }
+  return NULL;
+}
+
+void *mpmc_consume(void *arg) {
+  char rec[256];
+  (void)arg;
+  while (__atomic_load_n(&received, __ATOMIC_RELAXED) < total) {
+    if (ringbuf_mpmc_get(q, rec, sizeof(rec)) >= 0) {
+      __atomic_add_fetch(&received, 1, __ATOMIC_RELAXED);
+    } else sched_yield();
+  }
+  return NULL;
+}
+
+double run(size_t pairs, void *(*prod)(void*), void *(*cons)(void*)) {
+  pthread_t p[16], c[16];
+  struct timespec a, b;
+  size_t k;
+
+  per_producer = total / pairs;
+  total = per_producer * pairs;
+  received = 0;
+  clock_gettime(CLOCK_MONOTONIC, &a);
+  for(k=0; k < pairs; k++) pthread_create(&c[k], NULL, cons, NULL);
+  for(k=0; k < pairs; k++) pthread_create(&p[k], NULL, prod, NULL);
+  for(k=0; k < pairs; k++) pthread_join(p[k], NULL);
+  for(k=0; k < pairs; k++) pthread_join(c[k], NULL);
+  clock_gettime(CLOCK_MONOTONIC, &b);
+  return (b.tv_sec - a.tv_sec) + (b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+  double mtx_s, mpmc_s;
+  size_t pairs;
+
+  if (argc > 1) total = strtoul(argv[1], NULL, 10) * 1000 * 1000;
+  if (argc > 2) rec_sz = strtoul(argv[2], NULL, 10);
+  if (rec_sz > 256) rec_sz = 256;
+
+  rb = ringbuf_new(4096 * (RINGBUF_MSG_HDR + rec_sz));
+  q = ringbuf_mpmc_new(4096, rec_sz);
+  if ((rb == NULL) || (q == NULL)) return -1;
+
+  printf("%lu records of %lu bytes, 4096 record queue\n", total, rec_sz);
+  printf("%6s %16s %16s\n", "pairs", "mutex Mrec/s", "mpmc Mrec/s");
+  for(pairs = 1; pairs <= 16; pairs *= 2) {
+    mtx_s = run(pairs, mtx_produce, mtx_consume);
+    mpmc_s = run(pairs, mpmc_produce, mpmc_consume);
+    printf("%6lu %16.2f %16.2f\n", pairs, total / mtx_s / 1e6, total / mpmc_s / 1e6);
+  }
+
+  ringbuf_free(rb);
+  ringbuf_mpmc_free(q);
+  return 0;
+}
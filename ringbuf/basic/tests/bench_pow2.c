@@ -0,0 +1,56 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ringbuf.h"
+
+/* small puts (and the consume that follows each batch of
+ * them) on a ringbuf_new ring, which wraps its indices 
+ * with %, and on a ringbuf_new_pow2 ring of the same 
+ * size, which masks them.
+ *
+ * usage: bench_pow2 [million-ops] [ring-sz]
+ */
+
+size_t ops = 100UL * 1000 * 1000;
+size_t ring_sz = 64 * 1024;
+
+double run(ringbuf *r, size_t rec_sz) {
+  struct timespec a, b;
+  char rec[16] = {0}, *d;
+  size_t i, sz;
+
+  clock_gettime(CLOCK_MONOTONIC, &a);
+  for(i=0; i < ops; i++) {
+    if (ringbuf_put(r, rec, rec_sz) == 0) continue;
+    while ((sz = ringbuf_get_next_chunk(r, &d)) > 0) ringbuf_mark_consumed(r, sz);
+    ringbuf_put(r, rec, rec_sz);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &b);
+  return (b.tv_sec - a.tv_sec) + (b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+  ringbuf *r, *p;
+  double r_s, p_s;
+  size_t rec_sz;
+
+  if (argc > 1) ops = strtoul(argv[1], NULL, 10) * 1000 * 1000;
+  if (argc > 2) ring_sz = strtoul(argv[2], NULL, 10);
+
+  p = ringbuf_new_pow2(ring_sz);
+  if (p == NULL) return -1;
+  r = ringbuf_new(p->n);
+  if (r == NULL) return -1;
+
+  printf("%lu puts into a %lu byte ring\n", ops, p->n);
+  printf("%8s %16s %16s\n", "rec_sz", "modulo Mops/s", "pow2 Mops/s");
+  for(rec_sz = 1; rec_sz <= 16; rec_sz *= 2) {
+    r_s = run(r, rec_sz);
+    p_s = run(p, rec_sz);
+    printf("%8lu %16.1f %16.1f\n", rec_sz, ops / r_s / 1e6, ops / p_s / 1e6);
+  }
+
+  ringbuf_free(r);
+  ringbuf_free(p);
+  return 0;
+}
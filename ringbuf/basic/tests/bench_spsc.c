@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "ringbuf.h"
+#include "ringbuf_spsc.h"
+
+/* throughput of one producer and one consumer thread,
+ * comparing a mutex-wrapped ringbuf to ringbuf_spsc.
+ *
+ * usage: bench_spsc [total-mb] [ring-sz]
+ */
+
+size_t total = 256UL * 1024 * 1024;
+size_t ring_sz = 64 * 1024;
+size_t rec_sizes[] = {16, 64, 256, 1024, 4096};
+size_t rec_sz;
+
+ringbuf *rb;
+pthread_mutex_t mtx = PTHREAD_MUTEX_INITIALIZER;
+ringbuf_spsc *rs;
+
+void *mtx_produce(void *arg) {
+  (void)arg;
+  char buf[4096] = {0};
+  size_t i=0;
+  int rc;
+  while(i < total) {
+    pthread_mutex_lock(&mtx);
+    rc = ringbuf_put(rb, buf, rec_sz);
+    pthread_mutex_unlock(&mtx);
+    if (rc == 0) i += rec_sz;
+    else sched_yield();
+  }
+  return NULL;
+}
+
+void *mtx_consume(void *arg) {
+  (void)arg;
+  size_t i=0, sz;
+  char *d;
+  while(i < total) {
+    pthread_mutex_lock(&mtx);
+    sz = ringbuf_get_next_chunk(rb, &d);
+    ringbuf_mark_consumed(rb, sz);
+    pthread_mutex_unlock(&mtx);
+    if (sz == 0) sched_yield();
+    i += sz;
+  }
+  return NULL;
+}
+
+void *spsc_produce(void *arg) {
+  (void)arg;
+  char buf[4096] = {0};
+  size_t i=0;
+  while(i < total) {
+    if (ringbuf_spsc_put(rs, buf, rec_sz) == 0) i += rec_sz;
+    else sched_yield();
+  }
+  return NULL;
+}
+
+void *spsc_consume(void *arg) {
+  (void)arg;
+  size_t i=0, sz;
+  char *d;
+  while(i < total) {
+    sz = ringbuf_spsc_get_next_chunk(rs, &d);
+    ringbuf_spsc_mark_consumed(rs, sz);
+    if (sz == 0) sched_yield();
+    i += sz;
+  }
+  return NULL;
+}
+
+double run(void *(*prod)(void*), void *(*cons)(void*)) {
+  struct timespec a, b;
+  pthread_t p, c;
+  clock_gettime(CLOCK_MONOTONIC, &a);
+  pthread_create(&c, NULL, cons, NULL);
+  pthread_create(&p, NULL, prod, NULL);
+  pthread_join(p, NULL);
+  pthread_join(c, NULL);
+  clock_gettime(CLOCK_MONOTONIC, &b);
+  return (b.tv_sec - a.tv_sec) + (b.tv_nsec - a.tv_nsec) / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+  double mtx_s, spsc_s, mb;
+  size_t j;
+
+  if (argc > 1) total = strtoul(argv[1], NULL, 10) * 1024 * 1024;
+  if (argc > 2) ring_sz = strtoul(argv[2], NULL, 10);
+  mb = total / (1024.0 * 1024);
+
+  rb = ringbuf_new(ring_sz);
+  rs = ringbuf_spsc_new(ring_sz);
+  if ((rb == NULL) || (rs == NULL)) return -1;
+
+  printf("%lu MB through a %lu byte ring\n", (unsigned long)mb, ring_sz);
+  printf("%8s %14s %14s\n", "rec_sz", "mutex MB/s", "spsc MB/s");
+  for(j=0; j < sizeof(rec_sizes)/sizeof(*rec_sizes); j++) {
+    rec_sz = rec_sizes[j];
+    ringbuf_clear(rb);
+    mtx_s = run(mtx_produce, mtx_consume);
+    spsc_s = run(spsc_produce, spsc_consume);
+    printf("%8lu %14.0f %14.0f\n", rec_sz, mb / mtx_s, mb / spsc_s);
+  }
+
+  ringbuf_free(rb);
+  ringbuf_spsc_free(rs);
+  return 0;
+}
@@ -8,7 +8,7 @@ int main() {
  size_t sz;
  int rc;
  char *d;
- char buf[32+11]; /* room for struct ring + 11 bytes of ring */
+ char buf[sizeof(ringbuf)+11]; /* room for struct ring + 11 bytes of ring */
 
  r = ringbuf_take(buf,sizeof(buf));
  printf("gave buffer (ringbuf_take) expecting 11 free bytes\n");
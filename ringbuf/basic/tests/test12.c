@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <unistd.h>
+#include "ringbuf.h"
+
+/* mirrored ring: pending data that wraps past the end 
+ * of the ring still comes back as one chunk */
+
+int main() {
+ ringbuf *r;
+ size_t sz, pg, n, k;
+ int rc, ok;
+ char *d, rec[300];
+
+ pg = sysconf(_SC_PAGESIZE);
+ r = ringbuf_new_mirrored(100);
+ printf("size rounded to page: %s\n", (r->n == pg) ? "yes" : "no");
+ n = r->n;
+
+ for(k=0; k < sizeof(rec); k++) rec[k] = 'a' + (k % 26);
+
+ printf("filling to 200 bytes short of the end\n");
+ rc = ringbuf_put(r, rec, 100);
+ while (ringbuf_get_freespace(r) > 200) rc |= ringbuf_put(r, rec, 100);
+ ringbuf_mark_consumed(r, ringbuf_get_pending_size(r));
+ printf("put: %s\n", (rc == -1) ? "failed" : "ok");
+
+ printf("putting 300 bytes across the end\n");
+ rc = ringbuf_put(r, rec, sizeof(rec));
+ printf("put: %s\n", (rc == -1) ? "failed" : "ok");
+ printf("input pos wrapped: %s\n", (r->i < r->o) ? "yes" : "no");
+
+ sz = ringbuf_get_next_chunk(r, &d);
+ printf("next chunk size %lu\n", sz);
+ ok = (memcmp(d, rec, sizeof(rec)) == 0);
+ printf("chunk matches: %s\n", ok ? "yes" : "no");
+ printf("wrapped part aliases start of ring: %s\n", 
+   (memcmp(r->d, &rec[n - (d - r->d)], r->i) == 0) ? "yes" : "no");
+ ringbuf_mark_consumed(r, sz);
+
+ printf("filling the whole ring\n");
+ for(k=0; k < n / 100; k++) rc = ringbuf_put(r, rec, 100);
+ rc = ringbuf_put(r, rec, n % 100);
+ printf("put: %s\n", (rc == -1) ? "failed" : "ok");
+ printf("buffer has %lu free bytes\n", ringbuf_get_freespace(r));
+ sz = ringbuf_get_next_chunk(r, &d);
+ printf("next chunk is whole ring: %s\n", (sz == n) ? "yes" : "no");
+ rc = ringbuf_put(r, rec, 1);
+ printf("put: %s\n", (rc == -1) ? "failed" : "ok");
+
+ ringbuf_free(r);
+ return 0;
+}
@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include "ringbuf.h"
+
+/* zero-copy producer: ringbuf_reserve + ringbuf_commit */
+
+int main() {
+ ringbuf *r;
+ size_t sz;
+ char *d, *s;
+
+ r = ringbuf_new(10);
+ printf("buffer of size 10 made\n");
+
+ sz = ringbuf_reserve(r, 4, &s);
+ printf("reserve 4: span sz %lu\n", sz);
+ memcpy(s, "abcd", 4);
+ printf("pending before commit %lu\n", ringbuf_get_pending_size(r));
+ ringbuf_commit(r, 4);
+ printf("pending after commit %lu\n", ringbuf_get_pending_size(r));
+
+ sz = ringbuf_reserve(r, 0, &s);
+ printf("reserve any: span sz %lu\n", sz);
+ memcpy(s, "efghij", 6);
+ ringbuf_commit(r, 6);
+ printf("buffer has %lu free bytes\n", ringbuf_get_freespace(r));
+
+ sz = ringbuf_reserve(r, 0, &s);
+ printf("reserve on full ring: span sz %lu (%s)\n", sz, s ? "span" : "null");
+
+ sz = ringbuf_get_next_chunk(r, &d);
+ printf("chunk sz %lu: %.*s\n", sz, (int)sz, d);
+ printf("consuming 7\n");
+ ringbuf_mark_consumed(r, 7);
+
+ /* free space wraps: 7 bytes at the start of the ring */
+ sz = ringbuf_reserve(r, 8, &s);
+ printf("reserve 8: span sz %lu\n", sz);
+ sz = ringbuf_reserve(r, 5, &s);
+ printf("reserve 5: span sz %lu\n", sz);
+ memcpy(s, "klmno", 5);
+ ringbuf_commit(r, 5);
+
+ sz = ringbuf_get_next_chunk(r, &d);
+ printf("chunk sz %lu: %.*s\n", sz, (int)sz, d);
+ ringbuf_mark_consumed(r, sz);
+ sz = ringbuf_get_next_chunk(r, &d);
+ printf("chunk sz %lu: %.*s\n", sz, (int)sz, d);
+ ringbuf_mark_consumed(r, sz);
+
+ /* empty ring with input near eob restarts at 0 */
+ sz = ringbuf_reserve(r, 10, &s);
+ printf("reserve 10 on empty ring: span sz %lu\n", sz);
+ printf("span at start of ring: %s\n", (s == r->d) ? "yes" : "no");
+
+ ringbuf_free(r);
+ return 0;
+}
@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <errno.h>
+#include "ringbuf.h"
+
+/* ringbuf_read_fd and ringbuf_write_fd through pipes,
+ * including data that wraps around the end of the ring */
+
+int main() {
+ ringbuf *r;
+ int in[2], out[2];
+ ssize_t rc;
+ char buf[20];
+
+ if (pipe(in) < 0 || pipe(out) < 0) return -1;
+ r = ringbuf_new(10);
+ printf("buffer of size 10 made\n");
+
+ printf("putting 7 bytes and consuming 6\n");
+ ringbuf_put(r, "abcdefg", 7);
+ ringbuf_mark_consumed(r, 6);
+
+ rc = write(in[1], "hijklmnopqrs", 12);
+ rc = ringbuf_read_fd(r, in[0]);
+ printf("read_fd: %ld\n", (long)rc);
+ printf("pending size %lu\n", ringbuf_get_pending_size(r));
+
+ rc = ringbuf_read_fd(r, in[0]);
+ printf("read_fd on full ring: %ld (%s)\n", (long)rc, 
+   (errno == ENOBUFS) ? "ENOBUFS" : "other");
+
+ rc = ringbuf_write_fd(r, out[1]);
+ printf("write_fd: %ld\n", (long)rc);
+ printf("pending size %lu\n", ringbuf_get_pending_size(r));
+ rc = read(out[0], buf, sizeof(buf));
+ printf("pipe got: %.*s\n", (int)rc, buf);
+
+ rc = ringbuf_read_fd(r, in[0]);
+ printf("read_fd: %ld\n", (long)rc);
+ close(in[1]);
+ rc = ringbuf_read_fd(r, in[0]);
+ printf("read_fd at eof: %ld\n", (long)rc);
+
+ rc = ringbuf_write_fd(r, out[1]);
+ printf("write_fd: %ld\n", (long)rc);
+ rc = read(out[0], buf, sizeof(buf));
+ printf("pipe got: %.*s\n", (int)rc, buf);
+
+ rc = ringbuf_write_fd(r, out[1]);
+ printf("write_fd on empty ring: %ld\n", (long)rc);
+
+ ringbuf_free(r);
+ return 0;
+}
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include "ringbuf_shm.h"
+
+/* a forked producer and a parent consumer share a small
+ * ring; both block in turn (full ring, empty ring). the
+ * eventfd signals the parent when the ring becomes non-empty */
+
+#define TOTAL (4UL * 1024 * 1024)
+
+static unsigned char expect(size_t i) { return (unsigned char)((i * 31) ^ (i >> 8)); }
+
+int main() {
+  ringbuf_shm *s;
+  unsigned char buf[101];
+  size_t i, k, len, sz, errors=0;
+  struct pollfd pfd;
+  uint64_t n;
+  char *d;
+  pid_t pid;
+  int rc;
+
+  s = ringbuf_shm_create(NULL, 4096, RINGBUF_SHM_EVENTFD);
+  printf("ring made: %s\n", s ? "yes" : "no");
+
+  pfd.fd = ringbuf_shm_get_eventfd(s);
+  pfd.events = POLLIN;
+  rc = poll(&pfd, 1, 0);
+  printf("eventfd readable while empty: %s\n", rc ? "yes" : "no");
+
+  pid = fork();
+  if (pid == 0) {
+    for(i=0; i < TOTAL; i += len) {
+      len = 1 + (i % sizeof(buf));
+      if (len > TOTAL - i) len = TOTAL - i;
+      for(k=0; k < len; k++) buf[k] = expect(i+k);
+      ringbuf_shm_put(s, buf, len, 1);
+    }
+    ringbuf_shm_close(s);
+    _exit(0);
+  }
+
+  rc = poll(&pfd, 1, -1);
+  printf("eventfd readable after put: %s\n", rc ? "yes" : "no");
+  rc = read(pfd.fd, &n, sizeof(n));
+
+  for(i=0; i < TOTAL; i += sz) {
+    sz = ringbuf_shm_get_next_chunk(s, &d, 1);
+    for(k=0; k < sz; k++) {
+      if ((unsigned char)d[k] != expect(i+k)) errors++;
+    }
+    ringbuf_shm_mark_consumed(s, sz);
+  }
+  waitpid(pid, NULL, 0);
+
+  printf("transferred %lu bytes\n", TOTAL);
+  printf("errors: %lu\n", errors);
+  printf("pending size %lu\n", ringbuf_shm_get_pending_size(s));
+  sz = ringbuf_shm_get_next_chunk(s, &d, 0);
+  printf("non-blocking get on empty ring: %lu\n", sz);
+  ringbuf_shm_close(s);
+
+  /* named; attach from a second mapping */
+  ringbuf_shm *a, *b;
+  a = ringbuf_shm_create("/ringbuf_test15", 4096, 0);
+  b = ringbuf_shm_attach("/ringbuf_test15");
+  ringbuf_shm_put(a, "hello", 5, 0);
+  sz = ringbuf_shm_get_next_chunk(b, &d, 0);
+  printf("attached ring got: %.*s\n", (int)sz, d);
+  ringbuf_shm_close(a);
+  ringbuf_shm_close(b);
+  ringbuf_shm_unlink("/ringbuf_test15");
+
+  /* a named ring with an eventfd can't be attached */
+  a = ringbuf_shm_create("/ringbuf_test15", 4096, RINGBUF_SHM_EVENTFD);
+  b = ringbuf_shm_attach("/ringbuf_test15");
+  printf("attach to ring with eventfd: %s\n", b ? "yes" : "no");
+  ringbuf_shm_close(a);
+  ringbuf_shm_unlink("/ringbuf_test15");
+  return 0;
+}
@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include "ringbuf.h"
+
+/* record mode: batches of length-framed records, 
+ * including records placed after a skip at eob */
+
+void show(ringbuf *r, size_t max) {
+  struct iovec msgs[10];
+  size_t k, n, bytes;
+  n = ringbuf_get_msgs(r, msgs, max, &bytes);
+  printf("got %lu msgs spanning %lu bytes:", n, bytes);
+  for(k=0; k < n; k++) printf(" [%.*s]", (int)msgs[k].iov_len, (char*)msgs[k].iov_base);
+  printf("\n");
+  ringbuf_mark_consumed(r, bytes);
+}
+
+int main() {
+ ringbuf *r;
+ size_t n;
+ int rc;
+ struct iovec in[4] = { {"ab",2}, {"cdef",4}, {"",0}, {"ghijklmnop",10} };
+
+ r = ringbuf_new(30);
+ printf("buffer of size 30 made\n");
+
+ n = ringbuf_put_msgs(r, in, 4);
+ printf("put_msgs: %lu of 4\n", n);
+ printf("pending size %lu\n", ringbuf_get_pending_size(r));
+ show(r, 2);
+ show(r, 10);
+ printf("pending size %lu\n", ringbuf_get_pending_size(r));
+
+ /* i is now 18. after qrstu it is 27, with 3 bytes to
+  * eob: too few for a header, so they are skipped */
+ rc = ringbuf_put_msg(r, "qrstu", 5);
+ rc = ringbuf_put_msg(r, "yz", 2);
+ printf("put_msg: %s\n", (rc == -1) ? "failed" : "ok");
+ printf("pending size %lu\n", ringbuf_get_pending_size(r));
+ show(r, 10);
+
+ /* i is now 6. after the next two it is 26, with 4 bytes
+  * to eob, so a wrap marker is left there */
+ rc = ringbuf_put_msg(r, "vw", 2);
+ rc = ringbuf_put_msg(r, "0123456789", 10);
+ show(r, 1);
+ rc = ringbuf_put_msg(r, "abcdefgh", 8);
+ printf("put_msg: %s\n", (rc == -1) ? "failed" : "ok");
+ printf("pending size %lu\n", ringbuf_get_pending_size(r));
+ rc = ringbuf_put_msg(r, "x", 1);
+ printf("put_msg with no room: %s\n", (rc == -1) ? "failed" : "ok");
+ show(r, 10);
+
+ rc = ringbuf_put_msg(r, "0123456789abcdefghijklmnopqrstuvwxyz", 27);
+ printf("put_msg too big for ring: %s\n", (rc == -1) ? "failed" : "ok");
+ rc = ringbuf_put_msg(r, "0123456789abcdefghijklmnopqrstuvwxyz", 26);
+ printf("put_msg filling empty ring: %s\n", (rc == -1) ? "failed" : "ok");
+ show(r, 10);
+ ringbuf_free(r);
+
+ r = ringbuf_new_mirrored(1);
+ printf("mirrored ring of size %lu made\n", r->n);
+ for(n=0; ringbuf_put_msg(r, "0123456789", 10) == 0; n++) ;
+ printf("put %lu msgs\n", n);
+ ringbuf_mark_consumed(r, 14 * 10);
+ rc = ringbuf_put_msg(r, "a record that crosses the end of the ring", 41);
+ printf("put_msg: %s\n", (rc == -1) ? "failed" : "ok");
+ ringbuf_mark_consumed(r, ringbuf_get_pending_size(r) - 45);
+ show(r, 10);
+ ringbuf_free(r);
+ return 0;
+}
@@ -0,0 +1,62 @@
+#include <stdio.h>
+#include "ringbuf.h"
+
+/* overwrite mode: puts evict the oldest data instead of
+ * failing; snapshots copy out the newest data */
+
+void show(ringbuf *r) {
+  struct iovec msgs[10];
+  size_t k, n, bytes;
+  n = ringbuf_get_msgs(r, msgs, 10, &bytes);
+  printf("%lu msgs:", n);
+  for(k=0; k < n; k++) printf(" [%.*s]", (int)msgs[k].iov_len, (char*)msgs[k].iov_base);
+  printf("\n");
+}
+
+int main() {
+ ringbuf *r;
+ size_t sz, k;
+ int rc;
+ char buf[32], *d;
+ uint32_t hdr;
+ char *recs[] = {"one","two","three","four","five","six","seven"};
+
+ r = ringbuf_new(10);
+ printf("byte ring of size 10 made\n");
+ rc = ringbuf_put(r, "abcdefgh", 8);
+ rc = ringbuf_put(r, "ijkl", 4);
+ printf("put without overwrite: %s\n", (rc == -1) ? "failed" : "ok");
+ ringbuf_set_overwrite(r, 1);
+ rc = ringbuf_put(r, "ijkl", 4);
+ printf("put with overwrite: %s\n", (rc == -1) ? "failed" : "ok");
+ sz = ringbuf_get_next_chunk(r, &d);
+ printf("chunk sz %lu: %.*s\n", sz, (int)sz, d);
+ sz = ringbuf_snapshot(r, buf, 5);
+ printf("snapshot of last 5: %.*s\n", (int)sz, buf);
+ sz = ringbuf_snapshot(r, buf, sizeof(buf));
+ printf("snapshot of all: %.*s\n", (int)sz, buf);
+ printf("pending size %lu\n", ringbuf_get_pending_size(r));
+ rc = ringbuf_put(r, "0123456789a", 11);
+ printf("put bigger than ring: %s\n", (rc == -1) ? "failed" : "ok");
+ ringbuf_free(r);
+
+ r = ringbuf_new(32);
+ ringbuf_set_overwrite(r, 1);
+ printf("record ring of size 32 made\n");
+ for(k=0; k < sizeof(recs)/sizeof(*recs); k++) {
+   rc = ringbuf_put_msg(r, recs[k], strlen(recs[k]));
+   printf("put %s: %s, ", recs[k], (rc == -1) ? "failed" : "ok");
+   show(r);
+ }
+
+ sz = ringbuf_snapshot_msgs(r, buf, 18);
+ printf("snapshot_msgs in 18 bytes: %lu bytes:", sz);
+ for(k=0; k < sz; k += sizeof(hdr) + hdr) {
+   memcpy(&hdr, &buf[k], sizeof(hdr));
+   printf(" [%.*s]", (int)hdr, &buf[k + sizeof(hdr)]);
+ }
+ printf("\n");
+ show(r);
+ ringbuf_free(r);
+ return 0;
+}
@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include "ringbuf.h"
+
+/* power-of-two ring: free-running indices */
+
+char z[11] = {'a','b','c','d','e','f','g','h','i','j','k'};
+
+int main() {
+ ringbuf *r;
+ size_t sz, bytes;
+ int rc;
+ char *d, buf[16];
+ struct iovec msgs[4];
+
+ r = ringbuf_new_pow2(11);
+ printf("asked for 11, got buffer of size %lu\n", r->n);
+ printf("buffer has %lu free bytes\n", ringbuf_get_freespace(r));
+
+ printf("putting 11, consuming 7, putting 8\n");
+ rc = ringbuf_put(r, z, 11);
+ ringbuf_mark_consumed(r, 7);
+ rc = ringbuf_put(r, z, 8);
+ printf("put: %s\n", (rc == -1) ? "failed" : "ok");
+ printf("buffer has %lu free bytes\n", ringbuf_get_freespace(r));
+ printf("pending size %lu\n", ringbuf_get_pending_size(r));
+ rc = ringbuf_put(r, z, 5);
+ printf("put 5 more: %s\n", (rc == -1) ? "failed" : "ok");
+ rc = ringbuf_put(r, z, 4);
+ printf("put 4 more: %s\n", (rc == -1) ? "failed" : "ok");
+ printf("full ring, i==o in position: pending size %lu\n", ringbuf_get_pending_size(r));
+
+ sz = ringbuf_get_next_chunk(r, &d);
+ printf("chunk sz %lu: %.*s\n", sz, (int)sz, d);
+ ringbuf_mark_consumed(r, sz);
+ sz = ringbuf_get_next_chunk(r, &d);
+ printf("chunk sz %lu: %.*s\n", sz, (int)sz, d);
+ sz = ringbuf_snapshot(r, buf, 6);
+ printf("snapshot of last 6: %.*s\n", (int)sz, buf);
+ ringbuf_mark_consumed(r, sz);
+ sz = ringbuf_get_next_chunk(r, &d);
+ printf("chunk sz %lu: %.*s\n", sz, (int)sz, d);
+ ringbuf_mark_consumed(r, sz);
+ sz = ringbuf_get_next_chunk(r, &d);
+ printf("empty ring: chunk sz %lu\n", sz);
+
+ printf("putting records across eob\n");
+ rc = ringbuf_put_msg(r, "abc", 3);
+ rc = ringbuf_put_msg(r, "xyz", 3);
+ printf("put_msg: %s\n", (rc == -1) ? "failed" : "ok");
+ sz = ringbuf_get_msgs(r, msgs, 4, &bytes);
+ printf("%lu msgs spanning %lu bytes: [%.*s] [%.*s]\n", sz, bytes,
+   (int)msgs[0].iov_len, (char*)msgs[0].iov_base,
+   (int)msgs[1].iov_len, (char*)msgs[1].iov_base);
+
+ ringbuf_free(r);
+ return 0;
+}
@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include "ringbuf_mpmc.h"
+
+/* four producer and four consumer threads share one 
+ * mpmc queue. each record is (producer, seq); every one
+ * must be received exactly once, and each consumer must
+ * see any one producer's records in order. */
+
+#define NTHREADS 4
+#define PER_PRODUCER 100000
+
+ringbuf_mpmc *q;
+unsigned char seen[NTHREADS][PER_PRODUCER];
+size_t received;
+
+struct rec { size_t p; size_t seq; char pad[40]; };
+
+void *produce(void *arg) {
+  struct rec r;
+  memset(&r, 0, sizeof(r));
+  r.p = (size_t)arg;
+  for(r.seq=0; r.seq < PER_PRODUCER; r.seq++) {
+    while (ringbuf_mpmc_put(q, &r, sizeof(r)) < 0) sched_yield();
+  }
+  return NULL;
+}
+
+void *consume(void *arg) {
+  size_t last[NTHREADS], k, *errors = (size_t*)arg;
+  struct rec r;
+  ssize_t rc;
+  for(k=0; k < NTHREADS; k++) last[k] = (size_t)-1;
+  while (__atomic_load_n(&received, __ATOMIC_RELAXED) < NTHREADS * PER_PRODUCER) {
+    rc = ringbuf_mpmc_get(q, &r, sizeof(r));
+    if (rc < 0) { sched_yield(); continue; }
+    if ((rc != sizeof(r)) || (r.p >= NTHREADS)) { (*errors)++; continue; }
+    if ((last[r.p] != (size_t)-1) && (r.seq <= last[r.p])) (*errors)++;
+    last[r.p] = r.seq;
+    seen[r.p][r.seq]++;
+    __atomic_add_fetch(&received, 1, __ATOMIC_RELAXED);
+  }
+  return NULL;
+}
+
+int main() {
+  pthread_t p[NTHREADS], c[NTHREADS];
+  size_t k, j, errors[NTHREADS] = {0}, bad = 0;
+  char big[100];
+
+  q = ringbuf_mpmc_new(1000, 64);
+  printf("queue of %lu cells made\n", q->mask + 1);
+  printf("put too big: %s\n", (ringbuf_mpmc_put(q, big, sizeof(big)) < 0) ? "failed" : "ok");
+  printf("get on empty: %ld\n", (long)ringbuf_mpmc_get(q, big, sizeof(big)));
+
+  for(k=0; k < NTHREADS; k++) pthread_create(&c[k], NULL, consume, &errors[k]);
+  for(k=0; k < NTHREADS; k++) pthread_create(&p[k], NULL, produce, (void*)k);
+  for(k=0; k < NTHREADS; k++) pthread_join(p[k], NULL);
+  for(k=0; k < NTHREADS; k++) pthread_join(c[k], NULL);
+
+  for(k=0; k < NTHREADS; k++) {
+    bad += errors[k];
+    for(j=0; j < PER_PRODUCER; j++) if (seen[k][j] != 1) bad++;
+  }
+  printf("received %lu records\n", received);
+  printf("errors: %lu\n", bad);
+  printf("get on empty: %ld\n", (long)ringbuf_mpmc_get(q, big, sizeof(big)));
+  ringbuf_mpmc_free(q);
+  return 0;
+}
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include "ringbuf_file.h"
+
+/* file-backed ring: recovery after a clean close, after
+ * a process that dies without closing, after one that 
+ * restarts an empty ring at the buffer start and dies, 
+ * after one that clears the ring and dies, and with both
+ * header slots corrupted */
+
+#define RING_PATH "test20.ring"
+
+void show(ringbuf *r) {
+  char *d;
+  size_t sz, left = ringbuf_get_pending_size(r);
+  printf("pending size %lu:", left);
+  while ((sz = ringbuf_get_next_chunk(r, &d)) > 0) {
+    printf(" %.*s", (int)sz, d);
+    ringbuf_mark_consumed(r, sz);
+  }
+  printf("\n");
+}
+
+int main() {
+  ringbuf_file *p;
+  char buf[60], *d;
+  pid_t pid;
+  int fd;
+
+  unlink(RING_PATH);
+  p = ringbuf_file_open(RING_PATH, 100);
+  printf("new ring of size %lu\n", p->r->n);
+  ringbuf_put(p->r, "abcdef", 6);
+  ringbuf_mark_consumed(p->r, 2);
+  ringbuf_file_close(p);
+
+  p = ringbuf_file_open(RING_PATH, 0);
+  printf("reopened ring of size %lu\n", p->r->n);
+  ringbuf_put(p->r, "ghij", 4);
+  ringbuf_file_close(p);
+
+  pid = fork();
+  if (pid == 0) { /* consume some, put more, die without closing */
+    p = ringbuf_file_open(RING_PATH, 0);
+    ringbuf_mark_consumed(p->r, 3);
+    ringbuf_put(p->r, "klm", 3);
+    ringbuf_file_sync(p);
+    ringbuf_put(p->r, "nop", 3);
+    ringbuf_mark_consumed(p->r, 1);
+    _exit(0);
+  }
+  waitpid(pid, NULL, 0);
+
+  p = ringbuf_file_open(RING_PATH, 0);
+  printf("after crash, ");
+  show(p->r);
+  ringbuf_put(p->r, "qrs", 3);
+  ringbuf_file_close(p);
+
+  /* drain most of a ring; a reserve that doesn't fit the
+   * tail moves the empty ring to the start of the buffer */
+  unlink(RING_PATH);
+  p = ringbuf_file_open(RING_PATH, 64);
+  memset(buf, '.', sizeof(buf));
+  ringbuf_put(p->r, buf, sizeof(buf));
+  ringbuf_mark_consumed(p->r, sizeof(buf));
+  ringbuf_file_close(p);
+  pid = fork();
+  if (pid == 0) {
+    p = ringbuf_file_open(RING_PATH, 0);
+    ringbuf_reserve(p->r, 10, &d);
+    memcpy(d, "0123456789", 10);
+    ringbuf_commit(p->r, 10);
+    _exit(0);
+  }
+  waitpid(pid, NULL, 0);
+  p = ringbuf_file_open(RING_PATH, 0);
+  printf("after restart and crash, ");
+  show(p->r);
+  ringbuf_put(p->r, "qrs", 3);
+  ringbuf_file_close(p);
+
+  /* a clear must not bring back the data it dropped */
+  unlink(RING_PATH);
+  p = ringbuf_file_open(RING_PATH, 64);
+  ringbuf_put(p->r, "stale-data", 10);
+  ringbuf_file_close(p);
+  pid = fork();
+  if (pid == 0) {
+    p = ringbuf_file_open(RING_PATH, 0);
+    ringbuf_clear(p->r);
+    ringbuf_put(p->r, "fresh", 5);
+    _exit(0);
+  }
+  waitpid(pid, NULL, 0);
+  p = ringbuf_file_open(RING_PATH, 0);
+  printf("after clear and crash, ");
+  show(p->r);
+  ringbuf_file_close(p);
+
+  /* clobber both header slots */
+  fd = open(RING_PATH, O_WRONLY);
+  pwrite(fd, "xxxx", 4, 0);
+  pwrite(fd, "xxxx", 4, RINGBUF_FILE_SLOT);
+  close(fd);
+  p = ringbuf_file_open(RING_PATH, 0);
+  printf("with no valid header, ");
+  show(p->r);
+  ringbuf_file_close(p);
+
+  unlink(RING_PATH);
+  return 0;
+}
@@ -0,0 +1,43 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "ringbuf_shm.h"
+
+/* a child dies holding the shared lock. the parent must
+ * not hang: it takes the lock over, keeps the pending data
+ * if the indices are intact, and drops it if they're torn */
+
+static void die_holding(ringbuf_shm *s, int tear) {
+  pid_t pid = fork();
+  if (pid == 0) {
+    pthread_mutex_lock(&s->h->lock);
+    if (tear) s->r->u += 3; /* as if killed mid-put */
+    _exit(0);
+  }
+  waitpid(pid, NULL, 0);
+}
+
+int main() {
+  ringbuf_shm *s;
+  char *d;
+  size_t sz;
+
+  alarm(10);
+  s = ringbuf_shm_create(NULL, 4096, 0);
+  ringbuf_shm_put(s, "hello", 5, 0);
+
+  die_holding(s, 0);
+  printf("pending after owner died: %lu\n", ringbuf_shm_get_pending_size(s));
+  sz = ringbuf_shm_get_next_chunk(s, &d, 0);
+  printf("got: %.*s\n", (int)sz, d);
+
+  die_holding(s, 1);
+  printf("pending after owner died mid-put: %lu\n", ringbuf_shm_get_pending_size(s));
+  printf("put after: %d\n", ringbuf_shm_put(s, "world", 5, 0));
+  sz = ringbuf_shm_get_next_chunk(s, &d, 0);
+  printf("got: %.*s\n", (int)sz, d);
+  ringbuf_shm_mark_consumed(s, sz);
+  printf("pending %lu\n", ringbuf_shm_get_pending_size(s));
+  ringbuf_shm_close(s);
+  return 0;
+}
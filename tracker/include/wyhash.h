@@ -0,0 +1,76 @@
+/* wyhash, final version 4, by Wang Yi <godspeed_china@yeah.net>.
+ * the upstream code is released into the public domain (unlicense).
+ * trimmed to the 64-bit hash of a byte string, for compilers with
+ * __uint128_t (gcc and clang on 64-bit targets). */
+
+#ifndef WYHASH_H
+#define WYHASH_H
+
+#include <stdint.h>
+#include <string.h>
+
+static inline void _wymum(uint64_t *A, uint64_t *B) {
+  __uint128_t r = *A;
+  r *= *B;
+  *A = (uint64_t)r;
+  *B = (uint64_t)(r >> 64);
+}
+
+static inline uint64_t _wymix(uint64_t A, uint64_t B) {
+  _wymum(&A, &B);
+  return A ^ B;
+}
+
+static inline uint64_t _wyr8(const uint8_t *p) { uint64_t v; memcpy(&v, p, 8); return v; }
+static inline uint64_t _wyr4(const uint8_t *p) { uint32_t v; memcpy(&v, p, 4); return v; }
+static inline uint64_t _wyr3(const uint8_t *p, size_t k) {
+  return (((uint64_t)p[0]) << 16) | (((uint64_t)p[k >> 1]) << 8) | p[k - 1];
+}
+
+/* the default secret */
+static const uint64_t _wyp[4] = {
+  0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull,
+  0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull
+};
+
+static inline uint64_t wyhash(const void *key, size_t len, uint64_t seed, 
+                              const uint64_t *secret) {
+  const uint8_t *p = (const uint8_t *)key;
+  uint64_t a, b;
+  seed ^= _wymix(seed ^ secret[0], secret[1]);
+  if (len <= 16) {
+    if (len >= 4) {
+      a = (_wyr4(p) << 32) | _wyr4(p + ((len >> 3) << 2));
+      b = (_wyr4(p + len - 4) << 32) | _wyr4(p + len - 4 - ((len >> 3) << 2));
+    } else if (len > 0) {
+      a = _wyr3(p, len);
+      b = 0;
+    } else a = b = 0;
+  } else {
+    size_t i = len;
+    if (i > 48) {
+      uint64_t see1 = seed, see2 = seed;
+      do {
+        seed = _wymix(_wyr8(p) ^ secret[1], _wyr8(p + 8) ^ seed);
+        see1 = _wymix(_wyr8(p + 16) ^ secret[2], _wyr8(p + 24) ^ see1);
+        see2 = _wymix(_wyr8(p + 32) ^ secret[3], _wyr8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i > 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = _wymix(_wyr8(p) ^ secret[1], _wyr8(p + 8) ^ seed);
+      i -= 16;
+      p += 16;
+    }
+    a = _wyr8(p + i - 16);
+    b = _wyr8(p + i - 8);
+  }
+  a ^= secret[1];
+  b ^= seed;
+  _wymum(&a, &b);
+  return _wymix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+#endif /* WYHASH_H */
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include "tracker.h"
+
+/* hits/sec of tracker_hit, one at a time, versus 
+ * tracker_hit_batch, with a cache much larger than the cpu
+ * cache. hits are Zipf(s) over nkeys URIs; the tracker is 
+ * warmed with one pass of the stream before each timed pass.
+ *
+ * usage: bench_batch [nhits] [nkeys] [cache_sz] [s]
+ */
+
+int nhits = 2000000;
+int nkeys = 4000000;
+int cache_sz = 2000000;
+double zipf_s = 0.8;
+int batch_szs[] = {16, 64, 256};
+
+char **hits;
+size_t *lens;
+time_t *whens;
+
+static double elapsed(struct timespec *a) {
+  struct timespec b;
+  clock_gettime(CLOCK_MONOTONIC, &b);
+  return (b.tv_sec - a->tv_sec) + (b.tv_nsec - a->tv_nsec) / 1e9;
+}
+
+static void report(char *what, double s) {
+  printf("%14s %12.0f %10.1f\n", what, nhits / s, s * 1e9 / nhits);
+}
+
+int main(int argc, char *argv[]) {
+  struct timespec a;
+  char **uris, name[32];
+  double *cdf, sum = 0, r;
+  int i, j, lo, hi, b;
+  tracker_t *t;
+
+  if (argc > 1) nhits = atoi(argv[1]);
+  if (argc > 2) nkeys = atoi(argv[2]);
+  if (argc > 3) cache_sz = atoi(argv[3]);
+  if (argc > 4) zipf_s = atof(argv[4]);
+
+  uris = malloc(nkeys * sizeof(char*));
+  cdf = malloc(nkeys * sizeof(double));
+  hits = malloc(nhits * sizeof(char*));
+  lens = malloc(nhits * sizeof(size_t));
+  whens = malloc(nhits * sizeof(time_t));
+  if (!uris || !cdf || !hits || !lens || !whens) return -1;
+  for(i=0; i < nkeys; i++) {
+    uris[i] = malloc(32);
+    snprintf(uris[i], 32, "/site/%d/index.html", i);
+    sum += 1.0 / pow(i+1, zipf_s);
+    cdf[i] = sum;
+  }
+  srand(1);
+  for(i=0; i < nhits; i++) {
+    r = sum * rand() / RAND_MAX;
+    for(lo=0, hi=nkeys-1; lo < hi; ) {
+      j = (lo + hi) / 2;
+      if (cdf[j] < r) lo = j+1; else hi = j;
+    }
+    hits[i] = uris[lo];
+    lens[i] = strlen(hits[i]);
+    whens[i] = i/1000;
+  }
+
+  printf("%d hits, %d keys (zipf s=%.2f), cache_sz %d\n", 
+    nhits, nkeys, zipf_s, cache_sz);
+  printf("%14s %12s %10s\n", "", "hits/sec", "ns/hit");
+
+  t = tracker_new(cache_sz, 100);
+  for(i=0; i < nhits; i++) tracker_hit(t, hits[i], whens[i]);
+  clock_gettime(CLOCK_MONOTONIC, &a);
+  for(i=0; i < nhits; i++) tracker_hit(t, hits[i], whens[i]);
+  report("tracker_hit", elapsed(&a));
+  tracker_free(t);
+
+  for(j=0; j < (int)(sizeof(batch_szs)/sizeof(*batch_szs)); j++) {
+    b = batch_szs[j];
+    t = tracker_new(cache_sz, 100);
+    for(i=0; i < nhits; i++) tracker_hit(t, hits[i], whens[i]);
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for(i=0; i < nhits; i += b) 
+      tracker_hit_batch(t, hits+i, lens+i, whens+i, (nhits-i < b) ? nhits-i : b);
+    snprintf(name, sizeof(name), "batch of %d", b);
+    report(name, elapsed(&a));
+    tracker_free(t);
+  }
+
+  for(i=0; i < nkeys; i++) free(uris[i]);
+  free(uris); free(cdf); free(hits); free(lens); free(whens);
+  return 0;
+}
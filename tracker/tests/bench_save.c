@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include "tracker.h"
+
+/* time to save, and to load back, a tracker holding n unique
+ * URIs, versus rebuilding it with n calls to tracker_hit.
+ *
+ * usage: bench_save [n] [path]
+ */
+
+int n = 1000000;
+char *path = "/tmp/bench_save.trk";
+
+static double elapsed(struct timespec *a) {
+  struct timespec b;
+  clock_gettime(CLOCK_MONOTONIC, &b);
+  return (b.tv_sec - a->tv_sec) + (b.tv_nsec - a->tv_nsec) / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+  struct timespec a;
+  char uri[64];
+  tracker_t *t;
+  int i;
+
+  if (argc > 1) n = atoi(argv[1]);
+  if (argc > 2) path = argv[2];
+
+  printf("%d unique uris\n", n);
+  t = tracker_new(n, 1000);
+  if (!t) return -1;
+  clock_gettime(CLOCK_MONOTONIC, &a);
+  for(i=0; i < n; i++) {
+    snprintf(uri, sizeof(uri), "/site/%d/index.html", i);
+    tracker_hit(t, uri, i/1000);
+  }
+  printf("%10s %8.2f s\n", "hit", elapsed(&a));
+
+  clock_gettime(CLOCK_MONOTONIC, &a);
+  if (tracker_save(t, path) < 0) return -1;
+  printf("%10s %8.2f s\n", "save", elapsed(&a));
+  tracker_free(t);
+
+  clock_gettime(CLOCK_MONOTONIC, &a);
+  if ( (t = tracker_load(path)) == NULL) return -1;
+  printf("%10s %8.2f s\n", "load", elapsed(&a));
+  tracker_free(t);
+  unlink(path);
+  return 0;
+}
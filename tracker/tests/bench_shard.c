@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include "tracker_shard.h"
+
+/* total hits/sec with nthreads threads hitting one tracker 
+ * behind a single mutex, versus a tracker sharded 64 ways. 
+ * the hits are a Zipf(1) stream over nkeys URIs; each thread
+ * takes its own slice of it.
+ *
+ * usage: bench_shard [nhits] [nkeys] [cache_sz]
+ */
+
+int nhits = 4000000;
+int nkeys = 1000000;
+int cache_sz = 100000;
+int nshards = 64;
+int nthreads[] = {1, 2, 4, 8, 16};
+
+char **hits;
+tracker_t *one;
+pthread_mutex_t one_lock = PTHREAD_MUTEX_INITIALIZER;
+tracker_sharded_t *s;
+
+typedef struct {
+  int lo, hi;
+} slice_t;
+
+void *hit_one(void *arg) {
+  slice_t *sl = (slice_t*)arg;
+  int i;
+  for(i=sl->lo; i < sl->hi; i++) {
+    pthread_mutex_lock(&one_lock);
+    tracker_hit(one, hits[i], i/1000);
+    pthread_mutex_unlock(&one_lock);
+  }
+  return NULL;
+}
+
+void *hit_sharded(void *arg) {
+  slice_t *sl = (slice_t*)arg;
+  int i;
+  for(i=sl->lo; i < sl->hi; i++) tracker_sharded_hit(s, hits[i], i/1000);
+  return NULL;
+}
+
+double run(void *(*fn)(void*), int n) {
+  struct timespec a, b;
+  pthread_t th[16];
+  slice_t sl[16];
+  int i;
+  clock_gettime(CLOCK_MONOTONIC, &a);
+  for(i=0; i < n; i++) {
+    sl[i].lo = (long)nhits * i / n;
+    sl[i].hi = (long)nhits * (i+1) / n;
+    pthread_create(&th[i], NULL, fn, &sl[i]);
+  }
+  for(i=0; i < n; i++) pthread_join(th[i], NULL);
+  clock_gettime(CLOCK_MONOTONIC, &b);
+  return nhits / ((b.tv_sec - a.tv_sec) + (b.tv_nsec - a.tv_nsec) / 1e9);
+}
+
+int main(int argc, char *argv[]) {
+  char **uris;
+  double *cdf, sum = 0, r, h1, h2;
+  int i, j, lo, hi;
+
+  if (argc > 1) nhits = atoi(argv[1]);
+  if (argc > 2) nkeys = atoi(argv[2]);
+  if (argc > 3) cache_sz = atoi(argv[3]);
+
+  uris = malloc(nkeys * sizeof(char*));
+  cdf = malloc(nkeys * sizeof(double));
+  hits = malloc(nhits * sizeof(char*));
+  if (!uris || !cdf || !hits) return -1;
+  for(i=0; i < nkeys; i++) {
+    uris[i] = malloc(32);
+    snprintf(uris[i], 32, "/site/%d/index.html", i);
+    sum += 1.0 / (i+1);
+    cdf[i] = sum;
+  }
+  srand(1);
+  for(i=0; i < nhits; i++) {
+    r = sum * rand() / RAND_MAX;
+    for(lo=0, hi=nkeys-1; lo < hi; ) {
+      j = (lo + hi) / 2;
+      if (cdf[j] < r) lo = j+1; else hi = j;
+    }
+    hits[i] = uris[lo];
+  }
+
+  printf("%d hits, %d keys (zipf), cache_sz %d, %d shards\n", 
+    nhits, nkeys, cache_sz, nshards);
+  printf("%8s %14s %14s\n", "threads", "mutex hits/s", "shard hits/s");
+  for(j=0; j < (int)(sizeof(nthreads)/sizeof(*nthreads)); j++) {
+    one = tracker_new(cache_sz, 100);
+    h1 = run(hit_one, nthreads[j]);
+    tracker_free(one);
+    s = tracker_sharded_new(nshards, cache_sz, 100);
+    h2 = run(hit_sharded, nthreads[j]);
+    tracker_sharded_free(s);
+    printf("%8d %14.0f %14.0f\n", nthreads[j], h1, h2);
+  }
+
+  for(i=0; i < nkeys; i++) free(uris[i]);
+  free(uris); free(cdf); free(hits);
+  return 0;
+}
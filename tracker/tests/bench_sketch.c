@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include <sys/wait.h>
+#include "tracker.h"
+
+/* lru vs space-saving engines on the same Zipf(s) stream: 
+ * memory, hits/sec, and top-K recall, i.e. the fraction of the
+ * true top_sz uri's (by exact count over the whole stream) 
+ * that the tracker's top list holds. each run is in its own
+ * process so its resident size can be measured cleanly.
+ *
+ * usage: bench_sketch [nhits] [nkeys] [top_sz] [s]
+ */
+
+int nhits = 5000000;
+int nkeys = 1000000;
+int top_sz = 1000;
+double zipf_s = 1.0;
+int cache_szs[] = {1000, 10000, 100000};
+
+char **uris;
+int *hits, *truth;
+
+static long rss_kb(void) {
+  long pages = 0, res = 0;
+  FILE *f = fopen("/proc/self/statm", "r");
+  if (!f) return 0;
+  if (fscanf(f, "%ld %ld", &pages, &res) != 2) res = 0;
+  fclose(f);
+  return res * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static int by_count_desc(const void *_a, const void *_b) {
+  int a = *(int*)_a, b = *(int*)_b;
+  return (truth[b] > truth[a]) - (truth[b] < truth[a]);
+}
+
+static void run(int mode, int cache_sz, int *top) {
+  struct timespec a, b;
+  tracker_t *t;
+  uri_t **up = NULL;
+  long rss = rss_kb();
+  int i, k, found = 0;
+  double s;
+
+  t = (mode == TRACKER_SPACE_SAVING) ? tracker_new_ss(cache_sz, top_sz)
+                                     : tracker_new(cache_sz, top_sz);
+  clock_gettime(CLOCK_MONOTONIC, &a);
+  for(i=0; i < nhits; i++) tracker_hit(t, uris[hits[i]], i/1000);
+  clock_gettime(CLOCK_MONOTONIC, &b);
+  s = (b.tv_sec - a.tv_sec) + (b.tv_nsec - a.tv_nsec) / 1e9;
+  rss = rss_kb() - rss;
+
+  while ( (up = (uri_t**)utarray_next(&t->top, up))) {
+    if (sscanf(uri_key(*up), "/site/%d", &k) != 1) continue;
+    for(i=0; i < top_sz; i++) if (top[i] == k) { found++; break; }
+  }
+  printf("%6s %9d %9.1f %12.0f %8.3f %8u\n", 
+    mode == TRACKER_SPACE_SAVING ? "ss" : "lru", cache_sz, 
+    rss / 1024.0, nhits / s, (double)found / top_sz, 
+    tracker_error_bound(t));
+  fflush(stdout);
+  tracker_free(t);
+}
+
+int main(int argc, char *argv[]) {
+  double *cdf, sum = 0, r;
+  int i, j, lo, hi, *top;
+
+  if (argc > 1) nhits = atoi(argv[1]);
+  if (argc > 2) nkeys = atoi(argv[2]);
+  if (argc > 3) top_sz = atoi(argv[3]);
+  if (argc > 4) zipf_s = atof(argv[4]);
+
+  uris = malloc(nkeys * sizeof(char*));
+  cdf = malloc(nkeys * sizeof(double));
+  hits = malloc(nhits * sizeof(int));
+  truth = calloc(nkeys, sizeof(int));
+  top = malloc(nkeys * sizeof(int));
+  if (!uris || !cdf || !hits || !truth || !top) return -1;
+  for(i=0; i < nkeys; i++) {
+    uris[i] = malloc(32);
+    snprintf(uris[i], 32, "/site/%d/index.html", i);
+    sum += 1.0 / pow(i+1, zipf_s);
+    cdf[i] = sum;
+  }
+  /* shuffle ranks over keys so hot keys aren't also low ids */
+  srand(1);
+  for(i=nkeys-1; i > 0; i--) {
+    char *tmp = uris[i];
+    j = rand() % (i+1);
+    uris[i] = uris[j];
+    uris[j] = tmp;
+  }
+  for(i=0; i < nhits; i++) {
+    r = sum * rand() / RAND_MAX;
+    for(lo=0, hi=nkeys-1; lo < hi; ) {
+      j = (lo + hi) / 2;
+      if (cdf[j] < r) lo = j+1; else hi = j;
+    }
+    hits[i] = lo;
+  }
+
+  /* exact top_sz by id, as uris[] index -> key number */
+  for(i=0; i < nkeys; i++) top[i] = i;
+  for(i=0; i < nhits; i++) truth[hits[i]]++;
+  qsort(top, nkeys, sizeof(int), by_count_desc);
+  for(i=0; i < top_sz; i++) sscanf(uris[top[i]], "/site/%d", &top[i]);
+
+  printf("%d hits, %d keys (zipf s=%.2f), top_sz %d\n", 
+    nhits, nkeys, zipf_s, top_sz);
+  printf("%6s %9s %9s %12s %8s %8s\n", 
+    "engine", "cache_sz", "rss MB", "hits/sec", "recall", "err");
+  fflush(stdout);
+  for(j=0; j < (int)(sizeof(cache_szs)/sizeof(*cache_szs)); j++) {
+    for(i=TRACKER_LRU; i <= TRACKER_SPACE_SAVING; i++) {
+      pid_t pid = fork();
+      if (pid == 0) { run(i, cache_szs[j], top); exit(0); }
+      if (pid > 0) waitpid(pid, NULL, 0);
+    }
+  }
+
+  for(i=0; i < nkeys; i++) free(uris[i]);
+  free(uris); free(cdf); free(hits); free(truth); free(top);
+  return 0;
+}
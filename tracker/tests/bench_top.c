@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "tracker.h"
+
+/* hits/sec of tracker_hit as top_sz grows. the hits 
+ * are drawn from a Zipf(1) distribution over nkeys URIs,
+ * generated up front so only tracker_hit is timed.
+ *
+ * usage: bench_top [nhits] [nkeys] [cache_sz]
+ */
+
+int nhits = 2000000;
+int nkeys = 1000000;
+int cache_sz = 100000;
+int top_szs[] = {10, 100, 1000, 10000};
+
+int main(int argc, char *argv[]) {
+  struct timespec a, b;
+  char **uris, **hits;
+  double *cdf, sum = 0, r, s;
+  int i, j, lo, hi;
+  tracker_t *t;
+
+  if (argc > 1) nhits = atoi(argv[1]);
+  if (argc > 2) nkeys = atoi(argv[2]);
+  if (argc > 3) cache_sz = atoi(argv[3]);
+
+  uris = malloc(nkeys * sizeof(char*));
+  cdf = malloc(nkeys * sizeof(double));
+  hits = malloc(nhits * sizeof(char*));
+  if (!uris || !cdf || !hits) return -1;
+  for(i=0; i < nkeys; i++) {
+    uris[i] = malloc(32);
+    snprintf(uris[i], 32, "/site/%d/index.html", i);
+    sum += 1.0 / (i+1);
+    cdf[i] = sum;
+  }
+  srand(1);
+  for(i=0; i < nhits; i++) {
+    r = sum * rand() / RAND_MAX;
+    for(lo=0, hi=nkeys-1; lo < hi; ) {
+      j = (lo + hi) / 2;
+      if (cdf[j] < r) lo = j+1; else hi = j;
+    }
+    hits[i] = uris[lo];
+  }
+
+  printf("%d hits, %d keys (zipf), cache_sz %d\n", nhits, nkeys, cache_sz);
+  printf("%8s %12s %10s\n", "top_sz", "hits/sec", "ns/hit");
+  for(j=0; j < (int)(sizeof(top_szs)/sizeof(*top_szs)); j++) {
+    t = tracker_new(cache_sz, top_szs[j]);
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for(i=0; i < nhits; i++) tracker_hit(t, hits[i], i/1000);
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    s = (b.tv_sec - a.tv_sec) + (b.tv_nsec - a.tv_nsec) / 1e9;
+    printf("%8d %12.0f %10.1f\n", top_szs[j], nhits / s, s * 1e9 / nhits);
+    tracker_free(t);
+  }
+
+  for(i=0; i < nkeys; i++) free(uris[i]);
+  free(uris); free(cdf); free(hits);
+  return 0;
+}
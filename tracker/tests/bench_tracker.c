@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include "tracker.h"
+
+/* benchmark for sizing a tracker and catching regressions. it
+ * drives one tracker with a synthetic stream of uri hits and 
+ * reports hits/sec, ns/hit percentiles, resident memory, and 
+ * top-K recall against exact counts of the whole stream.
+ *
+ * zipf    - rank r is hit in proportion to 1/r^s
+ * uniform - every uri equally likely
+ * bursty  - half the hits zipf; the other half go to 8 bursts,
+ *           each a random uri that is hot for a while and then
+ *           replaced by another
+ *
+ * the stream is generated before timing starts. hits are timed
+ * in chunks of CHUNK; one chunk in SAMPLE times each hit alone
+ * for the percentiles, and is left out of hits/sec.
+ */
+
+#define CHUNK 4096
+#define SAMPLE 16
+#define BURSTS 8
+
+struct {
+  char *dist;
+  char *engine;
+  int nkeys;
+  int nhits;
+  int cache_sz;
+  int top_sz;
+  int batch;
+  double s;
+  uint64_t seed;
+} CF = {
+  .dist = "zipf",
+  .engine = "lru",
+  .nkeys = 1000000,
+  .nhits = 10000000,
+  .cache_sz = 100000,
+  .top_sz = 100,
+  .batch = 0,
+  .s = 1.0,
+  .seed = 1,
+};
+
+void usage(char *prog) {
+  fprintf(stderr, "usage: %s [-d zipf|uniform|bursty] [-k <#uniques>] "
+                  "[-n <#hits>]\n"
+                  "          [-c <cache_sz>] [-t <top_sz>] [-s <zipf exponent>] "
+                  "[-e lru|ss]\n"
+                  "          [-b <batch size>] [-r <seed>]\n", prog);
+  exit(-1);
+}
+
+/* splitmix64 */
+static uint64_t rng(void) {
+  uint64_t z = (CF.seed += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static double rand01(void) { return (rng() >> 11) * (1.0 / 9007199254740992.0); }
+
+/*
+ * zipf by rejection-inversion (Hormann & Derflinger), so no 
+ * table of nkeys probabilities is needed. returns 1..nkeys
+ */
+static double zh1, zhn, zsv;
+
+static double helper1(double x) { return (fabs(x) > 1e-8) ? log1p(x) / x : 1 - x/2; }
+static double helper2(double x) { return (fabs(x) > 1e-8) ? expm1(x) / x : 1 + x/2; }
+static double zh(double x) { return exp(-CF.s * log(x)); }
+static double zhint(double x) { 
+  double lx = log(x); 
+  return helper2((1 - CF.s) * lx) * lx; 
+}
+static double zhint_inv(double x) {
+  double t = x * (1 - CF.s);
+  if (t < -1) t = -1;
+  return exp(helper1(t) * x);
+}
+
+static void zipf_init(void) {
+  zh1 = zhint(1.5) - 1;
+  zhn = zhint(CF.nkeys + 0.5);
+  zsv = 2 - zhint_inv(zhint(2.5) - zh(2));
+}
+
+static unsigned zipf(void) {
+  double u, x;
+  long k;
+  for(;;) {
+    u = zhn + rand01() * (zh1 - zhn);
+    x = zhint_inv(u);
+    k = (long)(x + 0.5);
+    if (k < 1) k = 1;
+    if (k > CF.nkeys) k = CF.nkeys;
+    if ((k - x <= zsv) || (u >= zhint(k + 0.5) - zh(k))) return k;
+  }
+}
+
+static unsigned next_key(long i) {
+  static unsigned key[BURSTS];
+  static long end[BURSTS];
+  int b;
+  if (!strcmp(CF.dist, "uniform")) return 1 + rng() % CF.nkeys;
+  if (!strcmp(CF.dist, "bursty") && (rng() & 1)) {
+    b = rng() % BURSTS;
+    if (i >= end[b]) {
+      key[b] = 1 + rng() % CF.nkeys;
+      end[b] = i + CF.nhits / 200 + rng() % (CF.nhits / 100 + 1);
+    }
+    return key[b];
+  }
+  return zipf();
+}
+
+static long rss_kb(void) {
+  char line[256];
+  long kb = 0;
+  FILE *f = fopen("/proc/self/status", "r");
+  if (!f) return 0;
+  while (fgets(line, sizeof(line), f)) {
+    if (!strncmp(line, "VmRSS:", 6)) kb = atol(line + 6);
+  }
+  fclose(f);
+  return kb;
+}
+
+static double now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int dbl_cmp(const void *_a, const void *_b) {
+  double a = *(double*)_a, b = *(double*)_b;
+  return (a > b) - (a < b);
+}
+
+/* ids of the top_sz keys by exact count, via a min-heap */
+static int true_top(unsigned *counts, unsigned *top) {
+  unsigned id, tmp;
+  int n = 0, i, c;
+  for(id=1; id <= (unsigned)CF.nkeys; id++) {
+    if (counts[id] == 0) continue;
+    if (n == CF.top_sz) {
+      if (counts[id] <= counts[top[0]]) continue;
+      top[0] = id;
+    } else {
+      top[n++] = id;
+      for(i = n-1; i > 0 && counts[top[(i-1)/2]] > counts[top[i]]; i = (i-1)/2) {
+        tmp = top[i]; top[i] = top[(i-1)/2]; top[(i-1)/2] = tmp;
+      }
+      continue;
+    }
+    for(i=0; (c = 2*i+1) < n; i = c) {
+      if ((c+1 < n) && (counts[top[c+1]] < counts[top[c]])) c++;
+      if (counts[top[i]] <= counts[top[c]]) break;
+      tmp = top[i]; top[i] = top[c]; top[c] = tmp;
+    }
+  }
+  return n;
+}
+
+int main(int argc, char *argv[]) {
+  static char keys[CHUNK][32];
+  char *kp[CHUNK];
+  size_t lens[CHUNK];
+  time_t whens[CHUNK];
+  unsigned *ids, *counts, *top, id;
+  double *lat, t0, t1, busy = 0, clk;
+  long i, j, m, nlat = 0, timed = 0, rss;
+  int opt, ntop, found = 0, k;
+  uri_t **up = NULL;
+  tracker_t *t;
+
+  while ( (opt = getopt(argc, argv, "d:k:n:c:t:s:e:b:r:h")) != -1) {
+    switch(opt) {
+      case 'd': CF.dist = strdup(optarg); break;
+      case 'k': CF.nkeys = atoi(optarg); break;
+      case 'n': CF.nhits = atoi(optarg); break;
+      case 'c': CF.cache_sz = atoi(optarg); break;
+      case 't': CF.top_sz = atoi(optarg); break;
+      case 's': CF.s = atof(optarg); break;
+      case 'e': CF.engine = strdup(optarg); break;
+      case 'b': CF.batch = atoi(optarg); break;
+      case 'r': CF.seed = strtoull(optarg, NULL, 10); break;
+      case 'h': default: usage(argv[0]); break;
+    }
+  }
+  if (strcmp(CF.dist, "zipf") && strcmp(CF.dist, "uniform") && 
+      strcmp(CF.dist, "bursty")) usage(argv[0]);
+  if (strcmp(CF.engine, "lru") && strcmp(CF.engine, "ss")) usage(argv[0]);
+  if ((CF.nkeys < 1) || (CF.nhits < 1) || (CF.cache_sz < 1) || 
+      (CF.top_sz < 1) || (CF.batch < 0)) usage(argv[0]);
+
+  ids = malloc(CF.nhits * sizeof(unsigned));
+  counts = calloc(CF.nkeys + 1, sizeof(unsigned));
+  top = malloc(CF.top_sz * sizeof(unsigned));
+  lat = malloc((CF.nhits / SAMPLE + CHUNK) * sizeof(double));
+  if (!ids || !counts || !top || !lat) {
+    fprintf(stderr, "out of memory\n");
+    return -1;
+  }
+  zipf_init();
+  for(i=0; i < CF.nhits; i++) {
+    ids[i] = next_key(i);
+    counts[ids[i]]++;
+  }
+  for(i=0; i < CHUNK; i++) kp[i] = keys[i];
+
+  /* cost of the timer itself, included in the percentiles */
+  clk = 1e9;
+  for(i=0; i < 1000; i++) {
+    t0 = now_ns();
+    t1 = now_ns();
+    if (t1 - t0 < clk) clk = t1 - t0;
+  }
+
+  rss = rss_kb();
+  t = strcmp(CF.engine, "ss") ? tracker_new(CF.cache_sz, CF.top_sz)
+                              : tracker_new_ss(CF.cache_sz, CF.top_sz);
+  if (!t) {
+    fprintf(stderr, "tracker_new failed\n");
+    return -1;
+  }
+  for(i=0; i < CF.nhits; i += m) {
+    m = (CF.nhits - i < CHUNK) ? (CF.nhits - i) : CHUNK;
+    for(j=0; j < m; j++) {
+      lens[j] = snprintf(keys[j], sizeof(keys[j]), "/site/%u/index.html", ids[i+j]);
+      whens[j] = (i+j) / 1000;
+    }
+    if ((i / CHUNK) % SAMPLE == SAMPLE-1) {
+      for(j=0; j < m; j++) {
+        t0 = now_ns();
+        tracker_hit(t, kp[j], whens[j]);
+        lat[nlat++] = now_ns() - t0;
+      }
+      continue;
+    }
+    t0 = now_ns();
+    if (CF.batch) {
+      for(j=0; j < m; j += CF.batch) 
+        tracker_hit_batch(t, kp+j, lens+j, whens+j, (m-j < CF.batch) ? m-j : CF.batch);
+    } else {
+      for(j=0; j < m; j++) tracker_hit(t, kp[j], whens[j]);
+    }
+    busy += now_ns() - t0;
+    timed += m;
+  }
+  rss = rss_kb() - rss;
+
+  ntop = true_top(counts, top);
+  while ( (up = (uri_t**)utarray_next(&t->top, up))) {
+    if (sscanf(uri_key(*up), "/site/%u", &id) != 1) continue;
+    for(k=0; k < ntop; k++) if (top[k] == id) { found++; break; }
+  }
+  qsort(lat, nlat, sizeof(double), dbl_cmp);
+
+  printf("%s", CF.dist);
+  if (strcmp(CF.dist, "uniform")) printf(" s=%.2f", CF.s);
+  printf(", %d uniques, %d hits, %s cache_sz %d top_sz %d", CF.nkeys, 
+    CF.nhits, CF.engine, CF.cache_sz, CF.top_sz);
+  if (CF.batch) printf(", batches of %d", CF.batch);
+  printf("\n");
+  printf("hits/sec  %.0f\n", timed ? timed / (busy / 1e9) : 0);
+  if (nlat) {
+    printf("ns/hit    p50 %.0f  p90 %.0f  p99 %.0f  p99.9 %.0f  max %.0f"
+           "  (timer %.0f)\n", lat[nlat/2], lat[nlat*9/10], lat[nlat*99/100],
+           lat[nlat*999/1000], lat[nlat-1], clk);
+  }
+  printf("rss       %.1f MB, %.0f bytes per cache slot\n", rss / 1024.0,
+    rss * 1024.0 / CF.cache_sz);
+  printf("recall    %.3f of the true top %d\n", ntop ? (double)found / ntop : 0, 
+    ntop);
+
+  tracker_free(t);
+  free(ids); free(counts); free(top); free(lat);
+  return 0;
+}
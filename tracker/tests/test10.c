@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "tracker.h"
+
+time_t when = 1317213882;
+
+/* the churn of test5, fed in uneven batches, some with lens 
+ * and some without, must leave the same top list */
+#define N 20000
+char uris[N][16];
+char *up[N];
+size_t lens[N];
+time_t whens[N];
+
+int main() {
+  unsigned long x = 1;
+  int i, k, n;
+  tracker_t *t = tracker_new(30,5);
+  for(i=0; i < N; i++) {
+    x = x * 6364136223846793005UL + 1442695040888963407UL;
+    k = (x >> 33) % 200;
+    k = (k * k) / 400;
+    snprintf(uris[i], sizeof(uris[i]), "/%d", k);
+    up[i] = uris[i];
+    lens[i] = strlen(uris[i]);
+    whens[i] = when + i/100;
+  }
+  for(i=0, n=1; i < N; i += n, n = (n * 7) % 41 + 1) {
+    if (n > N - i) n = N - i;
+    tracker_hit_batch(t, up+i, (n & 1) ? lens+i : NULL, whens+i, n);
+  }
+  show_tracker_top(t);
+  tracker_free(t);
+  return 0;
+}
@@ -0,0 +1,33 @@
+#include <stdio.h>
+#include <time.h>
+#include "tracker.h"
+
+time_t when = 1317213882;
+
+/* yesterday /old got a burst of 1000 hits. today /a and /b get
+ * a steady 100 and 50. plain counts keep /old on top; with a 
+ * one hour half-life it falls to the bottom. the second decay
+ * run spans 200 half-lives, so scores get rescaled on the way */
+void run(unsigned halflife, int days) {
+  tracker_t *t = tracker_new(10,3);
+  time_t now = when + days*86400;
+  uri_t **up = NULL;
+  int i;
+  if (halflife) tracker_set_halflife(t, halflife);
+  for(i=0; i < 1000; i++) tracker_hit(t, "/old", when + i);
+  for(i=0; i < 100; i++) tracker_hit(t, "/a", now - 3600 + i*36);
+  for(i=0; i < 50; i++) tracker_hit(t, "/b", now - 3600 + i*72);
+  show_tracker_top(t);
+  while ( (up = (uri_t**)utarray_next(&t->top, up))) {
+    printf(" %s decayed to %.3g\n", uri_key(*up), tracker_decayed(t, *up, now));
+  }
+  printf("\n");
+  tracker_free(t);
+}
+
+int main() {
+  run(0, 1);
+  run(3600, 1);
+  run(3600, 8);
+  return 0;
+}
@@ -0,0 +1,94 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include "tracker.h"
+
+time_t when = 1317213882;
+unsigned long x;
+
+/* the churn of test5 */
+void churn(tracker_t *t, int n) {
+  char uri[16];
+  int i, k;
+  for(i=0; i < n; i++) {
+    x = x * 6364136223846793005UL + 1442695040888963407UL;
+    k = (x >> 33) % 200;
+    k = (k * k) / 400;
+    snprintf(uri, sizeof(uri), "/%d", k);
+    tracker_hit(t, uri, when + i/100);
+  }
+}
+
+/* the bytes of t's snapshot */
+char *saved(tracker_t *t, char *path, long *len) {
+  char *d;
+  FILE *f;
+  if (tracker_save(t, path) < 0) exit(-1);
+  if ( (f = fopen(path, "r")) == NULL) exit(-1);
+  fseek(f, 0, SEEK_END);
+  *len = ftell(f);
+  rewind(f);
+  if ( (d = malloc(*len)) == NULL) exit(-1);
+  if (fread(d, 1, *len, f) != (size_t)*len) exit(-1);
+  fclose(f);
+  unlink(path);
+  return d;
+}
+
+/* a tracker saved part way through, and loaded back, must 
+ * carry on exactly as the original does */
+void run(tracker_t *a, char *path) {
+  tracker_t *b;
+  unsigned long x0;
+  char *sa, *sb;
+  long la, lb;
+  x = 1;
+  churn(a, 10000);
+  if (tracker_save(a, path) < 0) exit(-1);
+  if ( (b = tracker_load(path)) == NULL) exit(-1);
+  unlink(path);
+  show_tracker_top(b);
+  x0 = x;
+  churn(a, 10000);
+  x = x0;
+  churn(b, 10000);
+  show_tracker(a);
+  show_tracker_top(a);
+  show_tracker(b);
+  show_tracker_top(b);
+  sa = saved(a, path, &la);
+  sb = saved(b, path, &lb);
+  printf("original and loaded snapshots match: %s\n\n",
+         ((la == lb) && !memcmp(sa, sb, la)) ? "yes" : "no");
+  free(sa);
+  free(sb);
+  tracker_free(a);
+  tracker_free(b);
+}
+
+int main() {
+  char path[] = "/tmp/test12.XXXXXX";
+  int fd = mkstemp(path);
+  if (fd == -1) return -1;
+  close(fd);
+  run(tracker_new(30,5), path);
+  run(tracker_new_ss(30,5), path);
+
+  /* a snapshot whose header has a negative top_sz (the int
+   * after magic, version, mode and cache_sz) is refused */
+  int32_t bad = -1;
+  tracker_t *t = tracker_new(30,5);
+  if (tracker_save(t, path) < 0) return -1;
+  tracker_free(t);
+  if ( (fd = open(path, O_WRONLY)) == -1) return -1;
+  if (pwrite(fd, &bad, sizeof(bad), 16) != sizeof(bad)) return -1;
+  close(fd);
+  t = tracker_load(path);
+  printf("negative top_sz loaded: %s\n", t ? "yes" : "no");
+  if (t) tracker_free(t);
+  unlink(path);
+  return 0;
+}
@@ -0,0 +1,27 @@
+#include <stdio.h>
+#include <time.h>
+#include "tracker.h"
+
+time_t when = 1317213882;
+
+/* scores past 2^24. /a gets 20M hits, then a second later /b
+ * gets 17M, each worth a bit more than one of /a's. /a must
+ * stay on top: a hit still has to add to a score that big */
+#define NA 20000000
+#define NB 17000000
+
+int main() {
+  tracker_t *t = tracker_new(10,2);
+  unsigned ha = tracker_hash("/a", 2), hb = tracker_hash("/b", 2);
+  uri_t **up = NULL;
+  int i;
+  tracker_set_halflife(t, 3600);
+  for(i=0; i < NA; i++) tracker_hit_n(t, "/a", 2, ha, when);
+  for(i=0; i < NB; i++) tracker_hit_n(t, "/b", 2, hb, when + 1);
+  show_tracker_top(t);
+  while ( (up = (uri_t**)utarray_next(&t->top, up))) {
+    printf(" %s decayed to %.0f\n", uri_key(*up), tracker_decayed(t, *up, when + 1));
+  }
+  tracker_free(t);
+  return 0;
+}
@@ -0,0 +1,24 @@
+#include <stdio.h>
+#include <time.h>
+#include "tracker.h"
+
+time_t when = 1317213882;
+
+/* many hits with cache evictions and top list churn. 
+ * key k is hit with probability falling off with k. */
+int main() {
+  unsigned long x = 1;
+  char uri[16];
+  int i, k;
+  tracker_t *t = tracker_new(30,5);
+  for(i=0; i < 20000; i++) {
+    x = x * 6364136223846793005UL + 1442695040888963407UL;
+    k = (x >> 33) % 200;
+    k = (k * k) / 400;
+    snprintf(uri, sizeof(uri), "/%d", k);
+    tracker_hit(t, uri, when + i/100);
+  }
+  show_tracker_top(t);
+  tracker_free(t);
+  return 0;
+}
@@ -0,0 +1,29 @@
+#include <stdio.h>
+#include <time.h>
+#include "tracker.h"
+
+time_t when = 1317213882;
+
+/* /hot is hit in bursts of 5, with 40 other distinct uri's
+ * in between. a 30 slot lru cache forgets it between bursts;
+ * space-saving keeps it, since it is over 1/30th of hits */
+void run(tracker_t *t) {
+  char uri[16];
+  int i, j, k = 0;
+  for(i=0; i < 50; i++) {
+    for(j=0; j < 5; j++) tracker_hit(t, "/hot", when + i);
+    for(j=0; j < 40; j++) {
+      snprintf(uri, sizeof(uri), "/%d", k++ % 1000);
+      tracker_hit(t, uri, when + i);
+    }
+  }
+  show_tracker_top(t);
+  printf("error bound %u\n", tracker_error_bound(t));
+  tracker_free(t);
+}
+
+int main() {
+  run(tracker_new(30,3));
+  run(tracker_new_ss(30,3));
+  return 0;
+}
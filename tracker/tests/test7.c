@@ -0,0 +1,44 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "tracker.h"
+
+time_t when = 1317213882;
+char key[6000];
+
+/* key k is k*107 % 5000 bytes of its own letter, so some are
+ * inline, most are in the slab and a few are malloc'd. slots
+ * get reused often as the 20 slot cache evicts. */
+static int mkkey(int k) {
+  int len = 1 + (k * 107) % 5000;
+  memset(key, 'a' + k % 26, len);
+  key[len] = '\0';
+  return len;
+}
+
+int main() {
+  unsigned long x = 1;
+  uri_t **up = NULL, *u;
+  int i, k, len, bad = 0;
+  tracker_t *t = tracker_new(20,5);
+  for(i=0; i < 20000; i++) {
+    x = x * 6364136223846793005UL + 1442695040888963407UL;
+    k = (x >> 33) % 100;
+    k = (k * k) / 200;
+    mkkey(k);
+    tracker_hit(t, key, when + i/100);
+  }
+  while ( (up = (uri_t**)utarray_next(&t->top, up))) {
+    u = *up;
+    for(k=0; k < 50; k++) {
+      len = mkkey(k);
+      if (len != (int)uri_len(u) || memcmp(key, uri_key(u), len+1)) continue;
+      printf("key %d (%d bytes): %d\n", k, len, u->count);
+      break;
+    }
+    if (k == 50) bad++;
+  }
+  printf("%d bad keys\n", bad);
+  tracker_free(t);
+  return 0;
+}
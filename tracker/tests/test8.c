@@ -0,0 +1,32 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "tracker.h"
+
+time_t when = 1317213882;
+
+/* hits taken as length-delimited pieces of one buffer, with
+ * their hashes worked out before any of them are recorded */
+int main() {
+  char *log = "/a /bb /a /ccc /bb /a /dddd /a /ccc /eeeee /a";
+  const char *uris[16];
+  size_t lens[16];
+  unsigned hashes[16];
+  const char *p = log, *sp;
+  int i, n = 0;
+  tracker_t *t = tracker_new(4,2);
+  while (*p) {
+    sp = strchr(p, ' ');
+    if (!sp) sp = p + strlen(p);
+    uris[n] = p;
+    lens[n] = sp - p;
+    hashes[n] = tracker_hash(p, lens[n]);
+    n++;
+    p = *sp ? sp+1 : sp;
+  }
+  for(i=0; i < n; i++) tracker_hit_n(t, uris[i], lens[i], hashes[i], when);
+  show_tracker(t);
+  show_tracker_top(t);
+  tracker_free(t);
+  return 0;
+}
@@ -0,0 +1,51 @@
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include "tracker_shard.h"
+
+time_t when = 1317213882;
+
+/* 4 threads hit /0../19 into one sharded tracker, and the same
+ * into their own private trackers. /k gets k+1 hits per thread,
+ * spread across the run, and the caches never fill, so both 
+ * merged top lists are exact whatever the interleaving */
+tracker_sharded_t *s;
+tracker_t *mine[4];
+
+void *worker(void *arg) {
+  tracker_t *t = (tracker_t*)arg;
+  char uri[16];
+  int r, k;
+  for(r=0; r < 20; r++) {
+    for(k=r; k < 20; k++) {
+      snprintf(uri, sizeof(uri), "/%d", k);
+      tracker_sharded_hit(s, uri, when + r);
+      tracker_hit(t, uri, when + r);
+    }
+  }
+  return NULL;
+}
+
+void show(tracker_top_t *top, int n) {
+  int i;
+  for(i=0; i < n; i++) printf(" top> %s: %u\n", top[i].uri, top[i].count);
+  printf("\n");
+  tracker_top_done(top, n);
+}
+
+int main() {
+  pthread_t th[4];
+  tracker_top_t top[5];
+  int i;
+  s = tracker_sharded_new(8, 200, 5);
+  for(i=0; i < 4; i++) {
+    mine[i] = tracker_new(20, 5);
+    pthread_create(&th[i], NULL, worker, mine[i]);
+  }
+  for(i=0; i < 4; i++) pthread_join(th[i], NULL);
+  show(top, tracker_sharded_top(s, top, 5));
+  show(top, tracker_merge_top(mine, 4, top, 3));
+  for(i=0; i < 4; i++) tracker_free(mine[i]);
+  tracker_sharded_free(s);
+  return 0;
+}
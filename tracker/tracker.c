@@ -1,7 +1,22 @@
 #include <stdlib.h>
 #include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <stddef.h>
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "tracker.h"
+#ifdef TRACKER_SWISS
+#include "wyhash.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#endif
 
 /*
  * keep a backward looking event record of x uri's
@@ -14,113 +29,921 @@
  *
  */
 
-static void uri_init(uri_t *uri) { utstring_init(&uri->uri); }
-static void uri_fini(uri_t *uri) { utstring_done(&uri->uri); }
+static void uri_init(uri_t *uri) {
+  uri_len(uri) = 0;
+  uri->top_idx = -1;
+  uri->ss_idx = -1;
+}
+
+/*
+ * key slab. keys too long to store inline live in chunks of
+ * 64 << c bytes (c < TRACKER_SLAB_CLASSES) cut from 64k blocks.
+ * a chunk goes back on its class's free list when its slot is
+ * reused. keys longer than the largest class are malloc'd.
+ */
+#define SLAB_BLOCK 65536
+#define SLAB_MIN 64
+
+static int slab_class(size_t sz) {
+  int c = 0;
+  while (((size_t)SLAB_MIN << c) < sz) c++;
+  return c;
+}
+
+static void slab_release(tracker_t *t, char *p, size_t sz) {
+  int c = slab_class(sz);
+  if (c >= TRACKER_SLAB_CLASSES) { free(p); return; }
+  *(void**)p = t->slab_free[c];
+  t->slab_free[c] = p;
+}
+
+static char *slab_alloc(tracker_t *t, size_t sz) {
+  int c = slab_class(sz);
+  size_t csz = (size_t)SLAB_MIN << c;
+  char *p;
+  if (c >= TRACKER_SLAB_CLASSES) return malloc(sz);
+  if ((p = t->slab_free[c])) {
+    t->slab_free[c] = *(void**)p;
+    return p;
+  }
+  if (t->slab_left < csz) {
+    // hand the tail of the old block to the smaller classes
+    for(c=TRACKER_SLAB_CLASSES-1; c >= 0; c--) {
+      while (t->slab_left >= ((size_t)SLAB_MIN << c)) {
+        slab_release(t, t->slab, (size_t)SLAB_MIN << c);
+        t->slab += (size_t)SLAB_MIN << c;
+        t->slab_left -= (size_t)SLAB_MIN << c;
+      }
+    }
+    if ( (p = malloc(SLAB_BLOCK)) == NULL) return NULL;
+    *(void**)p = t->slab_blocks;   // first chunk links the blocks
+    t->slab_blocks = p;
+    t->slab = p + SLAB_MIN;
+    t->slab_left = SLAB_BLOCK - SLAB_MIN;
+  }
+  p = t->slab;
+  t->slab += csz;
+  t->slab_left -= csz;
+  return p;
+}
+
+static void key_release(tracker_t *t, uri_t *u) {
+  if (uri_len(u) >= TRACKER_KEY_INLINE) 
+    slab_release(t, u->key.out, uri_len(u)+1);
+  uri_len(u) = 0;
+}
+
+// store key in u, which must be out of the index. returns the copy
+static char *key_set(tracker_t *t, uri_t *u, const char *key, size_t len) {
+  char *k = u->key.in;
+  key_release(t, u);
+  if (len >= TRACKER_KEY_INLINE) {
+    if ( (k = slab_alloc(t, len+1)) == NULL) oom();
+    u->key.out = k;
+  }
+  memcpy(k, key, len);
+  k[len] = '\0';
+  uri_len(u) = len;
+  return k;
+}
+
+#define slot_at(t,i) (&(t)->uri_cache[i])
+#define slot_of(t,u) ((int)((u) - (t)->uri_cache))
+#define slots_used(t) ((t)->cache_sz - (t)->free_count)
+
+/*
+ * the index from key to slot. by default it is uthash, chained
+ * through the slots' hash handles. built with TRACKER_SWISS it is
+ * a swiss table of slot indexes, and the slots carry only their
+ * key length and hash. either way the rest of the tracker sees
+ * only idx_find, idx_add, idx_del and the prefetches below.
+ */
+#ifndef TRACKER_SWISS
+
+// the hash uthash gives key; tracker_hit_n takes it precomputed
+unsigned tracker_hash(const char *uri, size_t len) {
+  unsigned hashv, bkt;
+  HASH_FCN(uri, len, 1, hashv, bkt);
+  (void)bkt;
+  return hashv;
+}
+
+static int idx_init(tracker_t *t) {
+  (void)t;
+  return 0;
+}
+
+static void idx_free(tracker_t *t) {
+  HASH_CLEAR(hh,t->head);
+}
+
+// find key in the hash. cached hashes are compared before keys
+static uri_t *idx_find(tracker_t *t, const char *key, unsigned len, 
+                       unsigned hashv) {
+  UT_hash_handle *hh;
+  unsigned bkt;
+  if (!t->head) return NULL;
+  HASH_TO_BKT(hashv, t->head->hh.tbl->num_buckets, bkt);
+  hh = t->head->hh.tbl->buckets[bkt].hh_head;
+  for(; hh; hh = hh->hh_next) {
+    if ((hh->hashv == hashv) && (hh->keylen == len) && 
+        (memcmp(hh->key, key, len) == 0)) 
+      return ELMT_FROM_HH(t->head->hh.tbl, hh);
+  }
+  return NULL;
+}
+
+// u's key is set. uthash hashes it again itself
+static void idx_add(tracker_t *t, uri_t *u, unsigned hashv) {
+  (void)hashv;
+  HASH_ADD_KEYPTR(hh, t->head, uri_key(u), uri_len(u), u);
+}
+
+static void idx_del(tracker_t *t, uri_t *u) {
+  HASH_DELETE(hh, t->head, u);
+}
+
+// size the table once for n uri's, not by doubling as it fills.
+// uthash has no table until its first add, so call it after one
+static void idx_reserve(tracker_t *t, unsigned n) {
+  if (!t->head) return;
+  while (t->head->hh.tbl->num_buckets < n / 2) 
+    HASH_EXPAND_BUCKETS(t->head->hh.tbl);
+}
+
+// the two misses of a lookup: the bucket, then its chain head
+static void idx_prefetch(tracker_t *t, unsigned hashv) {
+  unsigned bkt;
+  if (!t->head) return;
+  HASH_TO_BKT(hashv, t->head->hh.tbl->num_buckets, bkt);
+  __builtin_prefetch(&t->head->hh.tbl->buckets[bkt]);
+}
+
+static void idx_prefetch_uri(tracker_t *t, unsigned hashv) {
+  UT_hash_handle *hh;
+  unsigned bkt;
+  if (!t->head) return;
+  HASH_TO_BKT(hashv, t->head->hh.tbl->num_buckets, bkt);
+  if ( (hh = t->head->hh.tbl->buckets[bkt].hh_head) == NULL) return;
+  __builtin_prefetch(hh);
+  __builtin_prefetch(ELMT_FROM_HH(t->head->hh.tbl, hh));
+}
+
+#else
+
+/*
+ * swiss table. the low 7 bits of a hash (h2) go in its entry's
+ * control byte; the rest pick the first group to probe, and 
+ * further groups follow triangularly, which visits every group
+ * since their number is a power of two. a probe compares h2 with
+ * all 16 control bytes of a group at once, and only entries that
+ * match are checked against the slot. it stops at a group with
+ * an empty entry, so a delete leaves a tombstone unless its 
+ * group has one already. the table is sized up front for the
+ * cache at most 3/4 full; when inserts have used up the empty
+ * entries down to 1/8, it is rebuilt in place without tombstones.
+ */
+#define GROUP 16
+#define H2(h) ((h) & 0x7f)
+
+// bit i is set if group entry i has control byte c
+static inline unsigned group_match(const uint8_t *g, uint8_t c) {
+#ifdef __SSE2__
+  __m128i v = _mm_load_si128((const __m128i*)g);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)c)));
+#else
+  unsigned m = 0;
+  int i;
+  for(i=0; i < GROUP; i++) if (g[i] == c) m |= 1U << i;
+  return m;
+#endif
+}
+
+// bit i is set if group entry i is empty or deleted
+static inline unsigned group_free(const uint8_t *g) {
+#ifdef __SSE2__
+  return _mm_movemask_epi8(_mm_load_si128((const __m128i*)g));
+#else
+  unsigned m = 0;
+  int i;
+  for(i=0; i < GROUP; i++) if (g[i] & 0x80) m |= 1U << i;
+  return m;
+#endif
+}
+
+// wyhash, folded to the width of uri_t.hash
+unsigned tracker_hash(const char *uri, size_t len) {
+  uint64_t h = wyhash(uri, len, 0, _wyp);
+  return (unsigned)(h ^ (h >> 32));
+}
+
+static size_t idx_cap(tracker_index_t *x) {
+  return ((size_t)x->mask + 1) * GROUP;
+}
+
+static int idx_alloc(tracker_index_t *x) {
+  size_t n = idx_cap(x);
+  x->slots = NULL;
+  if (posix_memalign((void**)&x->ctrl, 64, n)) return -1;
+  if (posix_memalign((void**)&x->slots, 64, n * sizeof(uint32_t))) {
+    free(x->ctrl);
+    return -1;
+  }
+  memset(x->ctrl, TRACKER_EMPTY, n);
+  x->growth_left = n / 8 * 7;
+  return 0;
+}
+
+static int idx_init(tracker_t *t) {
+  size_t groups = 1;
+  while (groups * GROUP / 4 * 3 < (size_t)t->cache_sz) groups *= 2;
+  t->idx.mask = groups - 1;
+  return idx_alloc(&t->idx);
+}
+
+static void idx_free(tracker_t *t) {
+  free(t->idx.ctrl);
+  free(t->idx.slots);
+}
+
+// put slot i in the first free entry on its probe sequence
+static void idx_put(tracker_index_t *x, unsigned hash, uint32_t i) {
+  unsigned g = (hash >> 7) & x->mask, step = 0, m;
+  size_t e;
+  while ( (m = group_free(x->ctrl + (size_t)g * GROUP)) == 0) 
+    g = (g + ++step) & x->mask;
+  e = (size_t)g * GROUP + __builtin_ctz(m);
+  if (x->ctrl[e] == TRACKER_EMPTY) x->growth_left--;
+  x->ctrl[e] = H2(hash);
+  x->slots[e] = i;
+}
+
+static void idx_rebuild(tracker_t *t) {
+  tracker_index_t old = t->idx;
+  size_t e, n = idx_cap(&old);
+  if (idx_alloc(&t->idx) < 0) oom();
+  for(e=0; e < n; e++) {
+    if (old.ctrl[e] & 0x80) continue;
+    idx_put(&t->idx, slot_at(t,old.slots[e])->hash, old.slots[e]);
+  }
+  free(old.ctrl);
+  free(old.slots);
+}
+
+static uri_t *idx_find(tracker_t *t, const char *key, unsigned len, 
+                       unsigned hash) {
+  tracker_index_t *x = &t->idx;
+  unsigned g = (hash >> 7) & x->mask, step = 0, m;
+  uint8_t *c;
+  uri_t *u;
+  for(;;) {
+    c = x->ctrl + (size_t)g * GROUP;
+    for(m = group_match(c, H2(hash)); m; m &= m-1) {
+      u = slot_at(t, x->slots[(size_t)g * GROUP + __builtin_ctz(m)]);
+      if ((u->hash == hash) && (u->keylen == len) && 
+          (memcmp(uri_key(u), key, len) == 0)) 
+        return u;
+    }
+    if (group_match(c, TRACKER_EMPTY)) return NULL;
+    g = (g + ++step) & x->mask;
+  }
+}
+
+// u's key is set and not yet in the index
+static void idx_add(tracker_t *t, uri_t *u, unsigned hash) {
+  u->hash = hash;
+  if (t->idx.growth_left == 0) idx_rebuild(t);
+  idx_put(&t->idx, hash, slot_of(t,u));
+}
+
+static void idx_del(tracker_t *t, uri_t *u) {
+  tracker_index_t *x = &t->idx;
+  unsigned g = (u->hash >> 7) & x->mask, step = 0, m;
+  uint32_t i = slot_of(t,u);
+  uint8_t *c;
+  size_t e;
+  for(;;) {
+    c = x->ctrl + (size_t)g * GROUP;
+    for(m = group_match(c, H2(u->hash)); m; m &= m-1) {
+      e = (size_t)g * GROUP + __builtin_ctz(m);
+      if (x->slots[e] != i) continue;
+      if (group_match(c, TRACKER_EMPTY)) {
+        x->ctrl[e] = TRACKER_EMPTY;
+        x->growth_left++;
+      } else x->ctrl[e] = TRACKER_DELETED;
+      return;
+    }
+    assert(!group_match(c, TRACKER_EMPTY));
+    g = (g + ++step) & x->mask;
+  }
+}
+
+// the table never grows
+static void idx_reserve(tracker_t *t, unsigned n) {
+  (void)t;
+  (void)n;
+}
+
+// the two misses of a lookup: the first group, then the slot
+// of its first h2 match
+static void idx_prefetch(tracker_t *t, unsigned hash) {
+  size_t e = (size_t)((hash >> 7) & t->idx.mask) * GROUP;
+  __builtin_prefetch(t->idx.ctrl + e);
+  __builtin_prefetch(t->idx.slots + e);
+}
+
+static void idx_prefetch_uri(tracker_t *t, unsigned hash) {
+  size_t e = (size_t)((hash >> 7) & t->idx.mask) * GROUP;
+  unsigned m = group_match(t->idx.ctrl + e, H2(hash));
+  uri_t *u;
+  if (!m) return;
+  u = slot_at(t, t->idx.slots[e + __builtin_ctz(m)]);
+  __builtin_prefetch(u);
+  __builtin_prefetch((char*)u + 64);
+}
+
+#endif
 
 tracker_t *tracker_new(int cache_sz, int top_sz) {
   int i;
   tracker_t *t = calloc(1,sizeof(tracker_t));
   if (!t) return NULL;
-  t->uri_cache = malloc(cache_sz * sizeof(uri_t));
-  if (!t->uri_cache) {free(t); return NULL;}
+  // slots are two cache lines; keep them from straddling a third
+  if (posix_memalign((void**)&t->uri_cache, 64, cache_sz * sizeof(uri_t))) {
+    free(t); 
+    return NULL;
+  }
   t->cache_sz = cache_sz;
+  if (idx_init(t) < 0) {
+    free(t->uri_cache);
+    free(t);
+    return NULL;
+  }
   t->top_sz = top_sz;
   t->free_uri = t->uri_cache;
   t->free_count = t->cache_sz;
+  t->lru_head = t->lru_tail = -1;
   for(i=0; i<t->cache_sz; i++) uri_init(&t->uri_cache[i]);
   utarray_init(&t->top,&ut_ptr_icd);
+  utarray_init(&t->ss,&ut_ptr_icd);
   return t;
 }
 
-// sort uri's by count. if count is equal sort old-to-new
+/* same cache of Y slots, but a full cache recycles the slot
+ * with the lowest count instead of the least recently hit */
+tracker_t *tracker_new_ss(int counters, int top_sz) {
+  tracker_t *t = tracker_new(counters, top_sz);
+  if (!t) return NULL;
+  t->mode = TRACKER_SPACE_SAVING;
+  utarray_reserve(&t->ss, counters);
+  return t;
+}
+
+// order uri's by score (only used with decay) then count. if
+// those are equal order old-to-new. seq may wrap, but uri's 
+// with the same last were hit within a second of each other
+static int top_cmp(uri_t *a, uri_t *b) {
+  if (a->score != b->score) return (a->score < b->score) ? -1 : 1;
+  if (a->count != b->count) return (a->count < b->count) ? -1 : 1;
+  if (a->last != b->last) return (a->last < b->last) ? -1 : 1;
+  if (a->seq != b->seq) return ((int)(a->seq - b->seq) < 0) ? -1 : 1;
+  return 0;
+}
+
 static int topsort_low_to_high(const void *_a, const void *_b) { 
   uri_t **a = (uri_t**)_a;
   uri_t **b = (uri_t**)_b;
-  int c = ((*a)->count - (*b)->count);
-  if (c) return c;
-  return (*a)->last - (*b)->last;
+  return top_cmp(*a, *b);
+}
+
+/*
+ * the top list is a binary min-heap of uri_t* ordered by
+ * top_cmp, so its lowest member is at index 0. each uri_t
+ * records its heap index, so finding, re-ranking or 
+ * removing a member is O(log top_sz) with no scan.
+ * the space-saving counter heap works the same way; off
+ * picks which index field in uri_t belongs to the heap.
+ */
+#define heap_at(h,i) (*(uri_t**)utarray_eltptr((h),(i)))
+#define heap_idx(u,off) (*(int*)((char*)(u) + (off)))
+#define TOP offsetof(uri_t,top_idx)
+#define SS offsetof(uri_t,ss_idx)
+
+static void heap_set(UT_array *h, size_t off, unsigned i, uri_t *u) {
+  heap_at(h,i) = u;
+  heap_idx(u,off) = i;
 }
 
-static int is_top(tracker_t *t, uri_t *u) {
-  size_t l = utarray_len(&t->top);
-  if (l < t->top_sz) return 1;
-  uri_t **f = (uri_t**)utarray_front(&t->top);
-  if (u->count >= (*f)->count) return 1;
+static void heap_sift_up(UT_array *h, size_t off, unsigned i) {
+  uri_t *u = heap_at(h,i);
+  while (i > 0) {
+    unsigned p = (i-1)/2;
+    if (top_cmp(heap_at(h,p), u) <= 0) break;
+    heap_set(h, off, i, heap_at(h,p));
+    i = p;
+  }
+  heap_set(h, off, i, u);
+}
+
+static void heap_sift_down(UT_array *h, size_t off, unsigned i) {
+  unsigned n = utarray_len(h), c;
+  uri_t *u = heap_at(h,i);
+  while ((c = 2*i+1) < n) {
+    if ((c+1 < n) && (top_cmp(heap_at(h,c+1), heap_at(h,c)) < 0)) c++;
+    if (top_cmp(u, heap_at(h,c)) <= 0) break;
+    heap_set(h, off, i, heap_at(h,c));
+    i = c;
+  }
+  heap_set(h, off, i, u);
+}
+
+static void heap_remove(UT_array *h, size_t off, uri_t *u) {
+  unsigned i = heap_idx(u,off), n = utarray_len(h);
+  uri_t *last = heap_at(h,n-1);
+  utarray_pop_back(h);
+  heap_idx(u,off) = -1;
+  if (last == u) return;
+  heap_set(h, off, i, last);
+  heap_sift_down(h, off, i);
+  heap_sift_up(h, off, heap_idx(last,off));
+}
+
+// u's count or last just went up. maintain top list
+static void top_update(tracker_t *t, uri_t *u) {
+  if (u->top_idx >= 0) {           // already in it; re-rank
+    heap_sift_down(&t->top, TOP, u->top_idx);
+  } else if (utarray_len(&t->top) < t->top_sz) {
+    utarray_push_back(&t->top, &u);
+    heap_sift_up(&t->top, TOP, utarray_len(&t->top)-1);
+  } else if ((t->top_sz > 0) && (top_cmp(u, heap_at(&t->top,0)) > 0)) {
+    heap_at(&t->top,0)->top_idx = -1; // displace the lowest
+    heap_set(&t->top, TOP, 0, u);
+    heap_sift_down(&t->top, TOP, 0);
+  }
+}
+
+// claim first free slot
+static uri_t *slot_claim(tracker_t *t) {
+  uri_t *u = t->free_uri; assert(u);
+  t->free_uri = (--t->free_count) ? (t->free_uri+1) : NULL;
+  u->count=0;
+  u->err=0;
+  u->last=0;
+  u->score=0;
+  return u;
+}
+
+/*
+ * recency order is a doubly-linked list through the slots, by
+ * slot index, separate from the index. the oldest uri is at
+ * lru_head. a repeat hit just relinks its slot at lru_tail.
+ */
+static void lru_unlink(tracker_t *t, uri_t *u) {
+  if (u->prev >= 0) slot_at(t,u->prev)->next = u->next;
+  else t->lru_head = u->next;
+  if (u->next >= 0) slot_at(t,u->next)->prev = u->prev;
+  else t->lru_tail = u->prev;
+}
+
+static void lru_append(tracker_t *t, uri_t *u) {
+  int i = slot_of(t,u);
+  u->prev = t->lru_tail;
+  u->next = -1;
+  if (t->lru_tail >= 0) slot_at(t,t->lru_tail)->next = i;
+  else t->lru_head = i;
+  t->lru_tail = i;
+}
+
+// slot for a new uri, evicting the least recently hit one
+static uri_t *lru_claim(tracker_t *t) {
+  uri_t *u;
+  // delete oldest one if at max 
+  if (t->free_count == 0) {
+    uri_t *oldest = slot_at(t,t->lru_head);
+    lru_unlink(t, oldest);
+    idx_del(t, oldest);
+    t->free_uri = oldest;
+    t->free_count=1;
+    // if it was in top list, clear record
+    if (oldest->top_idx >= 0) heap_remove(&t->top, TOP, oldest);
+  }
+  u = slot_claim(t);
+  lru_append(t, u);
+  return u;
+}
+
+// slot for a new uri, taking over the lowest counter. the 
+// newcomer inherits its count, which bounds its overestimate
+static uri_t *ss_claim(tracker_t *t) {
+  uri_t *u;
+  if (t->free_count) {
+    u = slot_claim(t);
+    utarray_push_back(&t->ss, &u);
+    heap_sift_up(&t->ss, SS, utarray_len(&t->ss)-1);
+    return u;
+  }
+  u = heap_at(&t->ss,0);
+  idx_del(t, u);
+  if (u->top_idx >= 0) heap_remove(&t->top, TOP, u);
+  u->err = u->count;
+  u->last = 0;
+  return u;
+}
+
+/*
+ * time decay. with a half-life h, a hit at time w is worth 
+ * 2^-(now-w)/h at time now. rather than decay every score as
+ * time passes, a hit adds 2^(w-landmark)/h to its uri's score;
+ * all scores then stand in the same ratio as their decayed 
+ * values, whatever now is, so the top heap never needs a 
+ * rescan. scores are doubles, so a hit still registers on a
+ * score of 2^52 times its weight; a float would stop growing at
+ * 2^24. to keep the weights bounded, the scores are scaled down
+ * and the landmark moved up, once every DECAY_RESCALE half-lives.
+ */
+#define DECAY_RESCALE 64
+
+int tracker_set_halflife(tracker_t *t, unsigned secs) {
+  if (t->mode != TRACKER_LRU) return -1;
+  if (t->hits) return -1;
+  t->halflife = secs;
   return 0;
 }
 
-static uri_t **lfind_in_top(tracker_t *t, uri_t *u) {
-  uri_t **up=NULL;
-  while( (up=(uri_t**)utarray_next(&t->top,up))) {
-    if (u == *up) return up;
+static void decay_rescale(tracker_t *t, int k) {
+  int i;
+  for(i=0; i < slots_used(t); i++) 
+    slot_at(t,i)->score = ldexp(slot_at(t,i)->score, -k);
+  t->landmark += (time_t)k * t->halflife;
+}
+
+static void decay_hit(tracker_t *t, uri_t *u, time_t when) {
+  double e;
+  if (t->hits == 0) t->landmark = when;
+  e = (double)(when - t->landmark) / t->halflife;
+  if (e > DECAY_RESCALE) {
+    decay_rescale(t, (int)e);
+    e = (double)(when - t->landmark) / t->halflife;
   }
-  return NULL;
+  u->score += exp2(e);
+}
+
+// u's hits as of now, each weighted down by its age
+double tracker_decayed(tracker_t *t, uri_t *u, time_t now) {
+  if (!t->halflife) return u->count;
+  return u->score * exp2((double)(t->landmark - now) / t->halflife);
 }
 
 void tracker_hit(tracker_t *t, char *uri, time_t when) {
+  size_t len = strlen(uri);
+  tracker_hit_n(t, uri, len, tracker_hash(uri, len), when);
+}
+
+/* uri need not be NUL-terminated. hash must be 
+ * tracker_hash(uri, len); callers can compute it ahead */
+void tracker_hit_n(tracker_t *t, const char *uri, size_t len, 
+                   unsigned hash, time_t when) {
   uri_t *u;
-  HASH_FIND(hh, t->head, uri, strlen(uri), u);
+  u = idx_find(t, uri, len, hash);
   if (!u) {
-    // delete oldest one if at max 
-    if (HASH_COUNT(t->head) == t->cache_sz) {
-      uri_t *oldest = t->head;
-      HASH_DELETE(hh, t->head, oldest);
-      t->free_uri = oldest;
-      t->free_count=1;
-      if (is_top(t,oldest)) { // if it was in top list, clear record
-        uri_t **p = lfind_in_top(t,oldest);
-        if (p) utarray_erase(&t->top,utarray_eltidx(&t->top,p),1);
-      }
-    }
-    // claim first free slot
-    u = t->free_uri; assert(u);
-    t->free_uri = (--t->free_count) ? (t->free_uri+1) : NULL;
-    utstring_clear(&u->uri);
-    utstring_bincpy(&u->uri, uri, strlen(uri));
-    u->count=0;
-    u->last=0;
-  } else {
-    HASH_DELETE(hh, t->head, u); // before promoting to newest 
+    u = (t->mode == TRACKER_SPACE_SAVING) ? ss_claim(t) : lru_claim(t);
+    key_set(t, u, uri, len);
+    idx_add(t, u, hash);
+  } else if ((t->mode == TRACKER_LRU) && (slot_of(t,u) != t->lru_tail)) {
+    lru_unlink(t, u);            // promote to newest
+    lru_append(t, u);
   }
-  char *uri_ptr = utstring_body(&u->uri);
-  int uri_len = utstring_len(&u->uri);
-  HASH_ADD_KEYPTR(hh, t->head, uri_ptr, uri_len, u); //newest
   u->count++;
   if (when > u->last) u->last=when;
-  if (is_top(t,u)) { // maintain top list
-    // may have higher-count items in t->uri_cache but 
-    // to avoid rescanning we'll insert this one. let
-    // statistics keep top good as long as cache_sz is
-    // long enough so true top sites don't roll off 
-    // between their periodic events coming in
-    if (!lfind_in_top(t,u)) utarray_push_back(&t->top,&u);
-    utarray_sort(&t->top,topsort_low_to_high);
-    if (utarray_len(&t->top) > t->top_sz) utarray_erase(&t->top,0,1);
+  u->seq = ++t->seq;
+  if (t->halflife) decay_hit(t, u, when);
+  t->hits++;
+  if (t->mode == TRACKER_SPACE_SAVING) heap_sift_down(&t->ss, SS, u->ss_idx);
+  // maintain top list. may have higher-count items in 
+  // t->uri_cache but to avoid rescanning we'll consider
+  // only this one. let statistics keep top good as long
+  // as cache_sz is long enough so true top sites don't
+  // roll off between their periodic events coming in
+  top_update(t,u);
+}
+
+/*
+ * batched hits. with a cache far larger than the cpu cache, a 
+ * hit mostly waits on two misses: the index entry (uthash bucket
+ * or swiss group), then the slot it leads to. so a batch is taken
+ * TRACKER_BATCH hits at a time: all are hashed and their entries
+ * prefetched, then the slots are prefetched, then the hits are 
+ * applied in order. the misses overlap instead of following one
+ * another.
+ * lens may be NULL if the uris are NUL-terminated.
+ */
+#define TRACKER_BATCH 16
+
+void tracker_hit_batch(tracker_t *t, char **uris, size_t *lens, 
+                       time_t *whens, int n) {
+  unsigned hashes[TRACKER_BATCH];
+  size_t l[TRACKER_BATCH];
+  int i, j, m;
+
+  for(i=0; i < n; i += m) {
+    m = (n - i < TRACKER_BATCH) ? (n - i) : TRACKER_BATCH;
+    for(j=0; j < m; j++) {
+      l[j] = lens ? lens[i+j] : strlen(uris[i+j]);
+      hashes[j] = tracker_hash(uris[i+j], l[j]);
+      idx_prefetch(t, hashes[j]);
+    }
+    for(j=0; j < m; j++) idx_prefetch_uri(t, hashes[j]);
+    for(j=0; j < m; j++) 
+      tracker_hit_n(t, uris[i+j], l[j], hashes[j], whens[i+j]);
   }
 }
 
+/* the most any space-saving count can overstate the truth by
+ * (the lowest counter, once all are in use). lru counts are 
+ * exact while tracked, so this is 0 for the lru engine. */
+unsigned tracker_error_bound(tracker_t *t) {
+  if (t->mode != TRACKER_SPACE_SAVING) return 0;
+  if (t->free_count) return 0;
+  return heap_at(&t->ss,0)->count;
+}
+
+// shows the cache, oldest first when the engine is lru,
+// otherwise in slot order
 void show_tracker(tracker_t *t) {
-  uri_t *u, *tmp;
-  HASH_ITER(hh, t->head, u, tmp) {
-    printf(" %s: %d\n",  utstring_body(&u->uri), u->count);
+  uri_t *u;
+  int i;
+  if (t->mode == TRACKER_LRU) {
+    for(i = t->lru_head; i >= 0; i = u->next) {
+      u = slot_at(t,i);
+      printf(" %s: %d\n",  uri_key(u), u->count);
+    }
+  } else {
+    for(i=0; i < slots_used(t); i++) {
+      u = slot_at(t,i);
+      printf(" %s: %d\n",  uri_key(u), u->count);
+    }
   }
   printf("\n");
 }
 
+// shows the top list low to high
 void show_tracker_top(tracker_t *t) {
   uri_t **up=NULL,*u;
-  while( (up=(uri_t**)utarray_next(&t->top,up))) {
+  UT_array top;
+  utarray_init(&top,&ut_ptr_icd);
+  utarray_concat(&top,&t->top);
+  utarray_sort(&top,topsort_low_to_high);
+  while( (up=(uri_t**)utarray_next(&top,up))) {
     u = *up;
-    printf(" top> %s: %d\n",  utstring_body(&u->uri), u->count);
+    printf(" top> %s: %d\n",  uri_key(u), u->count);
   }
   printf("\n");
+  utarray_done(&top);
 }
 
 void tracker_free(tracker_t *t) {
   int i;
-  HASH_CLEAR(hh,t->head);
-  for(i=0; i<t->cache_sz; i++) uri_fini(&t->uri_cache[i]);
+  void *b;
+  idx_free(t);
+  for(i=0; i<t->cache_sz; i++) key_release(t, &t->uri_cache[i]);
+  while ( (b = t->slab_blocks)) {
+    t->slab_blocks = *(void**)b;
+    free(b);
+  }
   free(t->uri_cache);
   utarray_done(&t->top);
+  utarray_done(&t->ss);
   free(t);
 }
+
+/*
+ * snapshots. a header, then one record per cached uri, each
+ * followed by its key bytes. lru uri's are written oldest first,
+ * so loading them in file order rebuilds the recency list. a 
+ * flag marks top list members, so the top list comes back as 
+ * it was rather than recomputed. the file is in host byte order.
+ */
+#define SAVE_MAGIC 0x544b5254  // "TRKT"
+#define SAVE_VERSION 2
+#define SAVE_TOP 0x1
+
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  int32_t mode;
+  int32_t cache_sz;
+  int32_t top_sz;
+  uint32_t seq;
+  uint32_t halflife;
+  uint32_t n;        // records
+  uint64_t hits;
+  int64_t landmark;
+} save_hdr;
+
+typedef struct {
+  uint32_t keylen;
+  uint32_t count;
+  uint32_t err;
+  uint32_t seq;
+  int64_t last;
+  double score;
+  uint32_t flags;
+  uint32_t unused;
+} save_rec;
+
+typedef struct {
+  int fd;
+  size_t n;
+  char d[1 << 16];
+} save_buf;
+
+static int save_flush(save_buf *b) {
+  char *p = b->d;
+  ssize_t rc;
+  while (b->n) {
+    rc = write(b->fd, p, b->n);
+    if (rc < 0) {
+      if (errno == EINTR) continue;
+      fprintf(stderr, "write: %s\n", strerror(errno));
+      return -1;
+    }
+    p += rc;
+    b->n -= rc;
+  }
+  return 0;
+}
+
+static int save_put(save_buf *b, const void *data, size_t len) {
+  const char *d = data;
+  size_t l;
+  while (len) {
+    if ((b->n == sizeof(b->d)) && (save_flush(b) < 0)) return -1;
+    l = sizeof(b->d) - b->n;
+    if (l > len) l = len;
+    memcpy(b->d + b->n, d, l);
+    b->n += l;
+    d += l;
+    len -= l;
+  }
+  return 0;
+}
+
+static int save_uri(save_buf *b, uri_t *u, int mode) {
+  save_rec r;
+  memset(&r, 0, sizeof(r));
+  r.keylen = uri_len(u);
+  r.count = u->count;
+  r.err = (mode == TRACKER_SPACE_SAVING) ? u->err : 0;
+  r.seq = u->seq;
+  r.last = u->last;
+  r.score = u->score;
+  r.flags = (u->top_idx >= 0) ? SAVE_TOP : 0;
+  if (save_put(b, &r, sizeof(r)) < 0) return -1;
+  return save_put(b, uri_key(u), r.keylen);
+}
+
+int tracker_save_fd(tracker_t *t, int fd) {
+  save_buf *b;
+  save_hdr h;
+  uri_t *u;
+  int i, rc = -1;
+
+  if ( (b = malloc(sizeof(*b))) == NULL) return -1;
+  b->fd = fd;
+  b->n = 0;
+  memset(&h, 0, sizeof(h));
+  h.magic = SAVE_MAGIC;
+  h.version = SAVE_VERSION;
+  h.mode = t->mode;
+  h.cache_sz = t->cache_sz;
+  h.top_sz = t->top_sz;
+  h.seq = t->seq;
+  h.halflife = t->halflife;
+  h.n = slots_used(t);
+  h.hits = t->hits;
+  h.landmark = t->landmark;
+  if (save_put(b, &h, sizeof(h)) < 0) goto done;
+  if (t->mode == TRACKER_LRU) {
+    for(i = t->lru_head; i >= 0; i = u->next) {
+      u = slot_at(t,i);
+      if (save_uri(b, u, t->mode) < 0) goto done;
+    }
+  } else {
+    for(i=0; i < slots_used(t); i++) {
+      if (save_uri(b, slot_at(t,i), t->mode) < 0) goto done;
+    }
+  }
+  if (save_flush(b) < 0) goto done;
+  rc = 0;
+
+ done:
+  free(b);
+  return rc;
+}
+
+int tracker_save(tracker_t *t, const char *path) {
+  int fd, rc;
+  fd = open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+  if (fd == -1) {
+    fprintf(stderr, "open %s: %s\n", path, strerror(errno));
+    return -1;
+  }
+  rc = tracker_save_fd(t, fd);
+  if (close(fd) < 0) rc = -1;
+  return rc;
+}
+
+// put a heap filled in arbitrary order into heap order
+static void heapify(UT_array *h, size_t off) {
+  unsigned i, n = utarray_len(h);
+  for(i=0; i < n; i++) heap_idx(heap_at(h,i),off) = i;
+  for(i=n/2; i > 0; i--) heap_sift_down(h, off, i-1);
+}
+
+/* the file is mapped and read through once. each uri goes 
+ * straight into the next free slot; nothing is re-hit */
+tracker_t *tracker_load_fd(int fd) {
+  tracker_t *t = NULL;
+  struct stat st;
+  char *m = MAP_FAILED, *p, *end;
+  save_hdr h;
+  save_rec r;
+  uri_t *u;
+  uint32_t i;
+
+  if (fstat(fd, &st) < 0) {
+    fprintf(stderr, "fstat: %s\n", strerror(errno));
+    goto done;
+  }
+  if ((size_t)st.st_size < sizeof(h)) goto bad;
+  m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (m == MAP_FAILED) {
+    fprintf(stderr, "mmap: %s\n", strerror(errno));
+    goto done;
+  }
+  madvise(m, st.st_size, MADV_SEQUENTIAL);
+  p = m;
+  end = m + st.st_size;
+  memcpy(&h, p, sizeof(h));
+  p += sizeof(h);
+  if ((h.magic != SAVE_MAGIC) || (h.version != SAVE_VERSION)) goto bad;
+  if ((h.mode != TRACKER_LRU) && (h.mode != TRACKER_SPACE_SAVING)) goto bad;
+  if ((h.cache_sz <= 0) || (h.n > (uint32_t)h.cache_sz)) goto bad;
+  if (h.top_sz < 0) goto bad;
+
+  t = (h.mode == TRACKER_SPACE_SAVING) ? tracker_new_ss(h.cache_sz, h.top_sz)
+                                       : tracker_new(h.cache_sz, h.top_sz);
+  if (!t) goto done;
+  t->seq = h.seq;
+  t->halflife = h.halflife;
+  t->hits = h.hits;
+  t->landmark = h.landmark;
+  utarray_reserve(&t->top, h.top_sz);
+
+  for(i=0; i < h.n; i++) {
+    if ((size_t)(end - p) < sizeof(r)) goto bad;
+    memcpy(&r, p, sizeof(r));
+    p += sizeof(r);
+    if ((size_t)(end - p) < r.keylen) goto bad;
+    u = slot_claim(t);
+    key_set(t, u, p, r.keylen);
+    idx_add(t, u, tracker_hash(p, r.keylen));
+    p += r.keylen;
+    if (i == 0) idx_reserve(t, h.n);
+    u->count = r.count;
+    u->seq = r.seq;
+    u->last = r.last;
+    u->score = r.score;
+    if (t->mode == TRACKER_LRU) lru_append(t, u);
+    else {
+      u->err = r.err;
+      utarray_push_back(&t->ss, &u);
+    }
+    if ((r.flags & SAVE_TOP) && ((int)utarray_len(&t->top) < t->top_sz))
+      utarray_push_back(&t->top, &u);
+  }
+  heapify(&t->top, TOP);
+  if (t->mode == TRACKER_SPACE_SAVING) heapify(&t->ss, SS);
+  goto done;
+
+ bad:
+  fprintf(stderr, "tracker_load: not a valid tracker snapshot\n");
+  if (t) tracker_free(t);
+  t = NULL;
+
+ done:
+  if (m != MAP_FAILED) munmap(m, st.st_size);
+  return t;
+}
+
+tracker_t *tracker_load(const char *path) {
+  tracker_t *t;
+  int fd = open(path, O_RDONLY);
+  if (fd == -1) {
+    fprintf(stderr, "open %s: %s\n", path, strerror(errno));
+    return NULL;
+  }
+  t = tracker_load_fd(fd);
+  close(fd);
+  return t;
+}
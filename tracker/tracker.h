@@ -1,31 +1,126 @@
 #include <time.h>
-#include "utstring.h"
+#include <stdint.h>
 #include "utarray.h"
+#ifndef TRACKER_SWISS
 #include "uthash.h"
+#endif
 
 /* tracker for top X sites in last Y requests */
 
-// this takes about 124 bytes per URI
-// so to track 1M unique URI's takes about 118 mb
+/* engines. TRACKER_LRU counts a uri exactly for as long as it
+ * stays among the last Y distinct uri's hit. TRACKER_SPACE_SAVING
+ * keeps Y counters and recycles the lowest one (Metwally et al.,
+ * "Space-Saving"); a count then overstates the true count by at
+ * most err, and err <= hits/Y. any uri hit more than hits/Y times
+ * is always tracked, no matter how its hits are spread out. */
+#define TRACKER_LRU          0
+#define TRACKER_SPACE_SAVING 1
+
+/* keys shorter than TRACKER_KEY_INLINE are stored in the slot 
+ * itself; longer ones in the tracker's key slab. either way they
+ * are NUL-terminated. by default the index is uthash, and a uri's
+ * length and hash are kept in its hash handle; with the default
+ * of 36 a slot is then 128 bytes (two cache lines), so to track
+ * 1M unique short URI's takes about 135 mb. built with 
+ * TRACKER_SWISS the index is an open-addressing table instead,
+ * a slot is 80 bytes, and 1M short URI's take about 90 mb */
+#ifndef TRACKER_KEY_INLINE
+#define TRACKER_KEY_INLINE 36
+#endif
+#define TRACKER_SLAB_CLASSES 7   // key slab chunks of 64..4096 bytes
+
 typedef struct {
-  UT_string uri;
-  time_t last;
+  union {
+    char in[TRACKER_KEY_INLINE];
+    char *out;
+  } __attribute__((packed, aligned(4))) key; // count fills the gap
   unsigned count;
+  time_t last;
+  double score;      // decay: hits weighted by time; see below
+  union {
+    struct {         // lru: neighbour slots in recency list, or -1
+      int prev;
+      int next;
+    };
+    struct {         // space-saving
+      unsigned err;  // overestimate bound
+      int ss_idx;    // position in counter heap
+    };
+  };
+  int top_idx;       // position in top heap, or -1
+  unsigned seq;      // hit sequence; breaks count/last ties
+#ifdef TRACKER_SWISS
+  unsigned keylen;
+  unsigned hash;     // tracker_hash of key
+#else
   UT_hash_handle hh;
+#endif
 } uri_t;
 
+#ifdef TRACKER_SWISS
+#define uri_len(u) ((u)->keylen)
+#else
+#define uri_len(u) ((u)->hh.keylen)
+#endif
+#define uri_key(u) \
+  ((uri_len(u) < TRACKER_KEY_INLINE) ? (u)->key.in : (u)->key.out)
+
+#ifdef TRACKER_SWISS
+/* swiss table. entries come in groups of 16, probed a group at a
+ * time. each has a control byte (TRACKER_EMPTY, TRACKER_DELETED,
+ * or the low 7 bits of its uri's hash) and its uri's slot index */
+#define TRACKER_EMPTY   0x80
+#define TRACKER_DELETED 0xfe
+
+typedef struct {
+  uint8_t *ctrl;
+  uint32_t *slots;
+  unsigned mask;        // groups - 1
+  unsigned growth_left; // inserts left before a rebuild
+} tracker_index_t;
+#endif
+
 typedef struct {
-  uri_t *head;
+#ifdef TRACKER_SWISS
+  tracker_index_t idx;
+#else
+  uri_t *head;   // hash of cached uri's
+#endif
   uri_t *uri_cache;
-  UT_array top;
+  int lru_head;  // lru: oldest slot, or -1
+  int lru_tail;  // lru: newest slot, or -1
+  UT_array top;  // min-heap of uri_t*; top[0] is lowest
+  UT_array ss;   // space-saving: min-heap of every tracked uri_t*
+  unsigned seq;
+  unsigned long hits;
+  unsigned halflife; // decay: seconds, or 0 for plain counts
+  time_t landmark;   // decay: time a hit's score is 1
+  int mode;      // TRACKER_LRU or TRACKER_SPACE_SAVING
   int cache_sz;  // Y
   int top_sz;    // X
   uri_t *free_uri;
   int free_count; // contiguous free slots starting at free_uri
+  char *slab;      // long keys: unused part of the newest slab block
+  size_t slab_left;
+  void *slab_blocks;
+  void *slab_free[TRACKER_SLAB_CLASSES]; // freed chunks by size class
 } tracker_t;
 
 tracker_t *tracker_new(int cache_sz, int top_sz);
+tracker_t *tracker_new_ss(int counters, int top_sz);
+unsigned tracker_error_bound(tracker_t *t);
+int tracker_set_halflife(tracker_t *t, unsigned secs);
+double tracker_decayed(tracker_t *t, uri_t *u, time_t now);
 void tracker_hit(tracker_t *t, char *uri, time_t when);
+void tracker_hit_n(tracker_t *t, const char *uri, size_t len, 
+                   unsigned hash, time_t when);
+unsigned tracker_hash(const char *uri, size_t len);
+void tracker_hit_batch(tracker_t *t, char **uris, size_t *lens, 
+                       time_t *whens, int n);
 void tracker_free(tracker_t *t);
+int tracker_save(tracker_t *t, const char *path);
+int tracker_save_fd(tracker_t *t, int fd);
+tracker_t *tracker_load(const char *path);
+tracker_t *tracker_load_fd(int fd);
 void show_tracker(tracker_t *t);
 void show_tracker_top(tracker_t *t);
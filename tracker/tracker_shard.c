@@ -0,0 +1,135 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "tracker_shard.h"
+#include "uthash.h"
+
+tracker_sharded_t *tracker_sharded_new(int nshards, int cache_sz, int top_sz) {
+  tracker_sharded_t *s;
+  int i, per = (cache_sz + nshards - 1) / nshards;
+
+  if (nshards < 1) return NULL;
+  s = calloc(1, sizeof(*s));
+  if (!s) return NULL;
+  if (posix_memalign((void**)&s->shards, TRACKER_CACHELINE, 
+                     nshards * sizeof(tracker_shard_t))) {
+    free(s);
+    return NULL;
+  }
+  for(i=0; i < nshards; i++) {
+    s->shards[i].t = tracker_new(per, top_sz);
+    if (!s->shards[i].t) goto fail;
+    pthread_mutex_init(&s->shards[i].lock, NULL);
+    s->nshards++;
+  }
+  return s;
+
+ fail:
+  tracker_sharded_free(s);
+  return NULL;
+}
+
+void tracker_sharded_free(tracker_sharded_t *s) {
+  int i;
+  for(i=0; i < s->nshards; i++) {
+    pthread_mutex_destroy(&s->shards[i].lock);
+    tracker_free(s->shards[i].t);
+  }
+  free(s->shards);
+  free(s);
+}
+
+/* the shard comes from the hash's high bits. uthash buckets and
+ * swiss groups use its low bits, so each shard's index still
+ * spreads well */
+void tracker_sharded_hit_n(tracker_sharded_t *s, const char *uri, 
+                           size_t len, unsigned hash, time_t when) {
+  tracker_shard_t *sh;
+  sh = &s->shards[((unsigned long long)hash * s->nshards) >> 32];
+  pthread_mutex_lock(&sh->lock);
+  tracker_hit_n(sh->t, uri, len, hash, when);
+  pthread_mutex_unlock(&sh->lock);
+}
+
+void tracker_sharded_hit(tracker_sharded_t *s, char *uri, time_t when) {
+  size_t len = strlen(uri);
+  tracker_sharded_hit_n(s, uri, len, tracker_hash(uri, len), when);
+}
+
+/*
+ * merging. every top list entry goes into a small hash of 
+ * candidates keyed by uri, summing counts, then the candidates
+ * are sorted and the first k kept. keys are copied, so a shard 
+ * only needs to be locked while its own top list is read.
+ */
+typedef struct {
+  char *uri;
+  unsigned count;
+  time_t last;
+  UT_hash_handle hh;
+} cand_t;
+
+static void merge_in(cand_t **cands, tracker_t *t) {
+  uri_t **up = NULL, *u;
+  cand_t *c;
+  while ( (up = (uri_t**)utarray_next(&t->top, up))) {
+    u = *up;
+    HASH_FIND(hh, *cands, uri_key(u), uri_len(u), c);
+    if (!c) {
+      if ( (c = calloc(1, sizeof(*c))) == NULL) oom();
+      if ( (c->uri = malloc(uri_len(u)+1)) == NULL) oom();
+      memcpy(c->uri, uri_key(u), uri_len(u)+1);
+      HASH_ADD_KEYPTR(hh, *cands, c->uri, uri_len(u), c);
+    }
+    c->count += u->count;
+    if (u->last > c->last) c->last = u->last;
+  }
+}
+
+// high to low by count, then by last hit, then by uri
+static int cand_cmp(cand_t *a, cand_t *b) {
+  if (a->count != b->count) return (a->count > b->count) ? -1 : 1;
+  if (a->last != b->last) return (a->last > b->last) ? -1 : 1;
+  if (a->hh.keylen != b->hh.keylen) return (a->hh.keylen < b->hh.keylen) ? -1 : 1;
+  return memcmp(a->uri, b->uri, a->hh.keylen);
+}
+
+static int merge_out(cand_t **cands, tracker_top_t *top, int k) {
+  cand_t *c, *tmp;
+  int n = 0;
+  HASH_SORT(*cands, cand_cmp);
+  HASH_ITER(hh, *cands, c, tmp) {
+    HASH_DEL(*cands, c);
+    if (n < k) {
+      top[n].uri = c->uri;
+      top[n].count = c->count;
+      top[n].last = c->last;
+      n++;
+    } else free(c->uri);
+    free(c);
+  }
+  return n;
+}
+
+int tracker_merge_top(tracker_t **ts, int n, tracker_top_t *top, int k) {
+  cand_t *cands = NULL;
+  int i;
+  for(i=0; i < n; i++) merge_in(&cands, ts[i]);
+  return merge_out(&cands, top, k);
+}
+
+int tracker_sharded_top(tracker_sharded_t *s, tracker_top_t *top, int k) {
+  cand_t *cands = NULL;
+  int i;
+  for(i=0; i < s->nshards; i++) {
+    pthread_mutex_lock(&s->shards[i].lock);
+    merge_in(&cands, s->shards[i].t);
+    pthread_mutex_unlock(&s->shards[i].lock);
+  }
+  return merge_out(&cands, top, k);
+}
+
+void tracker_top_done(tracker_top_t *top, int n) {
+  int i;
+  for(i=0; i < n; i++) free(top[i].uri);
+}
@@ -0,0 +1,50 @@
+#ifndef _TRACKER_SHARD_H_
+#define _TRACKER_SHARD_H_
+#include <pthread.h>
+#include "tracker.h"
+
+/* a tracker split by key hash into shards, for many threads 
+ * hitting at once. each shard is a private tracker_t with its
+ * own lock, on its own cache line, so threads only contend when
+ * their keys land in the same shard. a key always goes to the 
+ * same shard, so the shards' top lists are disjoint, and
+ * merging them gives an exact top k of the shards for any
+ * k <= top_sz. each shard caches and evicts on its own, so
+ * the counts can differ from those one big tracker would keep.
+ */
+
+#define TRACKER_CACHELINE 64
+
+typedef struct {
+  pthread_mutex_t lock;
+  tracker_t *t;
+} __attribute__((aligned(TRACKER_CACHELINE))) tracker_shard_t;
+
+typedef struct {
+  int nshards;
+  tracker_shard_t *shards;
+} tracker_sharded_t;
+
+/* an entry in a merged top list. uri is a malloc'd copy */
+typedef struct {
+  char *uri;
+  unsigned count;
+  time_t last;
+} tracker_top_t;
+
+/* cache_sz is split evenly over the shards. each shard keeps a
+ * top list of top_sz, so merges of up to top_sz are exact */
+tracker_sharded_t *tracker_sharded_new(int nshards, int cache_sz, int top_sz);
+void tracker_sharded_hit(tracker_sharded_t *s, char *uri, time_t when);
+void tracker_sharded_hit_n(tracker_sharded_t *s, const char *uri, 
+                           size_t len, unsigned hash, time_t when);
+int tracker_sharded_top(tracker_sharded_t *s, tracker_top_t *top, int k);
+void tracker_sharded_free(tracker_sharded_t *s);
+
+/* merge the top lists of n trackers (e.g. one per thread, not
+ * being hit meanwhile) into the k highest, counts of the same 
+ * uri summed. fills top[] high to low; returns how many */
+int tracker_merge_top(tracker_t **ts, int n, tracker_top_t *top, int k);
+void tracker_top_done(tracker_top_t *top, int n);
+
+#endif
@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ts.h"
+
+/* samples/sec of ts_add, one at a time, versus ts_add_batch. the
+ * stream is mostly in time order: rate samples per second, with 
+ * one in 20 arriving up to 30 seconds late. the series has 3600 
+ * one-second buckets of long sums, so it rotates every second.
+ *
+ * usage: bench_batch [nsamples] [rate]
+ */
+
+int nsamples = 20000000;
+int rate = 1000;
+int batch_szs[] = {100, 1000, 4000};
+
+time_t *whens;
+long *vals;
+void **datas;
+
+void insert(long *cur, long *incr) { *cur += *incr; }
+
+const ts_mm mm = {.sz=sizeof(long),
+                  .data=(ts_data_f*)insert};
+
+static double elapsed(struct timespec *a) {
+  struct timespec b;
+  clock_gettime(CLOCK_MONOTONIC, &b);
+  return (b.tv_sec - a->tv_sec) + (b.tv_nsec - a->tv_nsec) / 1e9;
+}
+
+static void report(char *what, double s) {
+  printf("%14s %12.0f %10.1f\n", what, nsamples / s, s * 1e9 / nsamples);
+}
+
+int main(int argc, char *argv[]) {
+  struct timespec a;
+  char name[32];
+  int i, j, b;
+  ts_t *t;
+
+  if (argc > 1) nsamples = atoi(argv[1]);
+  if (argc > 2) rate = atoi(argv[2]);
+
+  whens = malloc(nsamples * sizeof(time_t));
+  vals = malloc(nsamples * sizeof(long));
+  datas = malloc(nsamples * sizeof(void*));
+  if (!whens || !vals || !datas) return -1;
+  srand(1);
+  for(i=0; i < nsamples; i++) {
+    whens[i] = 100 + i / rate;
+    if (rand() % 20 == 0) whens[i] -= rand() % 30;
+    vals[i] = rand() % 100;
+    datas[i] = &vals[i];
+  }
+
+  printf("%d samples, %d/sec, 3600 buckets\n", nsamples, rate);
+  printf("%14s %12s %10s\n", "", "samples/sec", "ns/sample");
+
+  t = ts_new(3600, 1, &mm);
+  clock_gettime(CLOCK_MONOTONIC, &a);
+  for(i=0; i < nsamples; i++) ts_add(t, whens[i], datas[i]);
+  report("ts_add", elapsed(&a));
+  ts_free(t);
+
+  for(b=0; b < sizeof(batch_szs)/sizeof(*batch_szs); b++) {
+    t = ts_new(3600, 1, &mm);
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for(i=0; i < nsamples; i += j) {
+      j = (nsamples - i < batch_szs[b]) ? (nsamples - i) : batch_szs[b];
+      ts_add_batch(t, whens+i, datas+i, j);
+    }
+    snprintf(name, sizeof(name), "batch of %d", batch_szs[b]);
+    report(name, elapsed(&a));
+    ts_free(t);
+  }
+  return 0;
+}
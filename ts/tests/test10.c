@@ -0,0 +1,57 @@
+#include <stdio.h>
+#include <time.h>
+#include "ts.h"
+
+/* ts_add_batch against ts_add one sample at a time: in-order runs,
+ * stragglers, gaps that rotate part of the window or all of it */
+
+void insert(long *cur, long *incr) { *cur += *incr; }
+void show(long *i) { printf("%lu\n", *i); }
+
+const ts_mm mm = {.sz=sizeof(long),
+                  .data=(ts_data_f*)insert,
+                  .show=(ts_show_f*)show };
+
+unsigned long r = 1;
+unsigned rnd(unsigned n) { r = r * 6364136223846793005UL + 1442695040888963407UL; return (r >> 33) % n; }
+
+int same(ts_t *a, ts_t *b) {
+  int i;
+  if (a->base != b->base) return 0;
+  for(i=0; i<a->num_buckets; i++) {
+    if (bkt(a,i)->start != bkt(b,i)->start) return 0;
+    if (*(long*)bkt(a,i)->data != *(long*)bkt(b,i)->data) return 0;
+  }
+  return 1;
+}
+
+int main() {
+  time_t whens[100], now = 0;
+  long vals[100];
+  void *datas[100];
+  int i, j, n, ok = 1;
+
+  ts_t *a = ts_new(8,10,&mm);
+  ts_t *b = ts_new(8,10,&mm);
+  for(i=0; i < 2000; i++) {
+    n = rnd(100);
+    for(j=0; j < n; j++) {
+      switch(rnd(20)) {
+        case 0: now += 50 + rnd(100); break;   // gap
+        case 1: now += 200 + rnd(50); break;   // gap past the window
+        default: now += rnd(3); break;
+      }
+      whens[j] = (rnd(10) == 0) ? now - rnd(120) : now; // stragglers
+      vals[j] = rnd(5);
+      datas[j] = &vals[j];
+      ts_add(a, whens[j], datas[j]);
+    }
+    ts_add_batch(b, whens, datas, n);
+    if (!same(a,b)) { printf("batch %d differs\n", i); ok = 0; break; }
+  }
+  printf("%s\n", ok ? "same" : "differ");
+  ts_show(b);
+  ts_free(a);
+  ts_free(b);
+  return 0;
+}
@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <time.h>
+#include "ts.h"
+
+/* three tiers: 6 x 1s, 4 x 6s, 3 x 24s. one sample a second for
+ * 100 seconds, then one more after a gap, plus late samples that 
+ * only a coarser tier still covers. nothing is lost until it ages 
+ * out of the coarsest tier. */
+
+void insert(long *cur, long *incr) { *cur += *incr; }
+void show(long *i) { printf("%lu\n", *i); }
+
+const ts_mm mm = {.sz=sizeof(long),
+                  .data=(ts_data_f*)insert,
+                  .show=(ts_show_f*)show };
+
+long total(ts_t *t) {
+  long sum = 0;
+  int i;
+  for(; t; t = t->next) {
+    for(i=0; i < t->num_buckets; i++) sum += *(long*)bkt(t,i)->data;
+  }
+  return sum;
+}
+
+int main() {
+  unsigned num_buckets[] = {6, 4, 3};
+  unsigned secs_per_bucket[] = {1, 6, 24};
+  unsigned bad_secs[] = {1, 5, 24};
+  time_t i=0, whens[3] = {95, 40, 101};
+  long one=1, *ones[3] = {&one, &one, &one};
+  ts_t *t;
+
+  t = ts_new_tiered(3, num_buckets, bad_secs, &mm);
+  printf("%s\n", t ? "tiered" : "not tiered");
+
+  t = ts_new_tiered(3, num_buckets, secs_per_bucket, &mm);
+  for(i=0; i < 100; i++) ts_add(t, i, &one);
+  ts_show(t); ts_show(t->next); ts_show(t->next->next);
+  printf("total %ld\n\n", total(t));
+
+  ts_add(t, 60, &one);              // too old for the fine tier
+  ts_add_batch(t, whens, (void**)ones, 3);
+  ts_show(t); ts_show(t->next); ts_show(t->next->next);
+  printf("total %ld\n\n", total(t));
+
+  ts_add(t, 150, &one);
+  ts_show(t); ts_show(t->next); ts_show(t->next->next);
+  printf("total %ld\n", total(t));
+  ts_free(t);
+  return 0;
+}
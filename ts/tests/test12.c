@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "ts.h"
+
+/* ts_query against a scan of the buckets, over two tiers, while
+ * samples arrive one at a time and in batches. the payload counts
+ * its own samples, so count can be checked too, and so can min and
+ * max skipping the buckets that have none */
+
+typedef struct {
+  long sum;
+  long n;
+} sn_t;
+
+void insert(sn_t *cur, long *v) { cur->sum += *v; cur->n++; }
+void merge(sn_t *cur, sn_t *b) { cur->sum += b->sum; cur->n += b->n; }
+double value(sn_t *cur) { return cur->sum; }
+
+const ts_mm mm = {.sz=sizeof(sn_t),
+                  .data=(ts_data_f*)insert,
+                  .merge=(ts_data_f*)merge,
+                  .value=(ts_value_f*)value };
+
+unsigned long r = 1;
+unsigned rnd(unsigned n) { r = r * 6364136223846793005UL + 1442695040888963407UL; return (r >> 33) % n; }
+
+double scan(ts_t *t, time_t from, time_t to, int agg) {
+  double sum = 0, cnt = 0, min = INFINITY, max = -INFINITY, v;
+  ts_bucket *b;
+  int i;
+  for(; t && (from < to); t = t->next) {
+    for(i=0; i < t->num_buckets; i++) {
+      b = bkt(t,i);
+      if ((b->start >= to) || (b->start + t->secs_per_bucket <= from)) continue;
+      v = ((sn_t*)b->data)->sum;
+      sum += v;
+      cnt += ((sn_t*)b->data)->n;
+      if (((sn_t*)b->data)->n == 0) continue; // no value for min, max
+      if (v < min) min = v;
+      if (v > max) max = v;
+    }
+  }
+  switch(agg) {
+    case TS_AGG_SUM: return sum;
+    case TS_AGG_COUNT: return cnt;
+    case TS_AGG_MIN: return (min == INFINITY) ? NAN : min;
+    case TS_AGG_MAX: return (max == -INFINITY) ? NAN : max;
+    case TS_AGG_MEAN: return cnt ? sum / cnt : NAN;
+  }
+  return NAN;
+}
+
+int same(double a, double b) { return (isnan(a) && isnan(b)) || (a == b); }
+
+int main() {
+  unsigned num_buckets[] = {10, 6};
+  unsigned secs_per_bucket[] = {2, 10};
+  char *aggs[] = {"sum", "min", "max", "count", "mean"};
+  time_t now = 0, from, to, whens[20];
+  long vals[20];
+  void *datas[20];
+  int i, j, n, agg, bad = 0;
+  ts_t *t = ts_new_tiered(2, num_buckets, secs_per_bucket, &mm);
+
+  for(i=0; i < 5000 && !bad; i++) {
+    if (rnd(3)) {
+      now += rnd(4);
+      vals[0] = rnd(100);
+      ts_add(t, now - rnd(10), &vals[0]);
+    } else {
+      n = rnd(20);
+      for(j=0; j < n; j++) {
+        now += (rnd(50) == 0) ? 30 : rnd(2);
+        whens[j] = now;
+        vals[j] = rnd(100);
+        datas[j] = &vals[j];
+      }
+      ts_add_batch(t, whens, datas, n);
+    }
+    for(j=0; j < 5; j++) {
+      from = now - rnd(100);
+      to = from + rnd(100);
+      agg = rnd(5);
+      if (same(ts_query(t, from, to, agg), scan(t, from, to, agg))) continue;
+      printf("%s [%ld,%ld) at %ld: %g, scan %g\n", aggs[agg], (long)from,
+             (long)to, (long)now, ts_query(t, from, to, agg), 
+             scan(t, from, to, agg));
+      bad = 1;
+    }
+  }
+  printf("%s\n", bad ? "queries differ" : "queries agree");
+  for(agg=0; agg < 5; agg++) 
+    printf("%s %g\n", aggs[agg], ts_query(t, now - 60, now + 1, agg));
+  printf("empty %g %g\n", ts_query(t, now + 100, now + 200, TS_AGG_SUM), 
+         ts_query(t, now + 100, now + 200, TS_AGG_MAX));
+  ts_free(t);
+
+  /* 5 at t=0..15 on {10x1s, 10x10s}: [10,16) spans the coarse 
+   * tier's empty bucket [10,20) and fine buckets at 10..15 */
+  unsigned nb2[] = {10, 10}, spb2[] = {1, 10};
+  t = ts_new_tiered(2, nb2, spb2, &mm);
+  vals[0] = 5;
+  for(i=0; i < 16; i++) ts_add(t, i, &vals[0]);
+  printf("tiered min %g max %g\n", ts_query(t, 10, 16, TS_AGG_MIN),
+         ts_query(t, 10, 16, TS_AGG_MAX));
+  ts_free(t);
+
+  /* a gap in one tier */
+  t = ts_new(10, 1, &mm);
+  ts_add(t, 0, &vals[0]);
+  ts_add(t, 5, &vals[0]);
+  printf("gap min %g max %g, none %g\n", ts_query(t, 0, 10, TS_AGG_MIN),
+         ts_query(t, 0, 10, TS_AGG_MAX), ts_query(t, 1, 5, TS_AGG_MIN));
+  ts_free(t);
+  return 0;
+}
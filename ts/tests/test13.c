@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <time.h>
+#include "ts.h"
+
+/* test10 on a tiered series: ts_add_batch against ts_add one
+ * sample at a time, with rotations that cascade into the coarser
+ * tiers, restarts and stragglers old enough to skip a tier */
+
+void insert(long *cur, long *incr) { *cur += *incr; }
+void show(long *i) { printf("%lu\n", *i); }
+
+const ts_mm mm = {.sz=sizeof(long),
+                  .data=(ts_data_f*)insert,
+                  .show=(ts_show_f*)show };
+
+unsigned long r = 1;
+unsigned rnd(unsigned n) { r = r * 6364136223846793005UL + 1442695040888963407UL; return (r >> 33) % n; }
+
+int same(ts_t *a, ts_t *b) {
+  int i;
+  for(; a; a = a->next, b = b->next) {
+    if (a->base != b->base) return 0;
+    for(i=0; i<a->num_buckets; i++) {
+      if (bkt(a,i)->start != bkt(b,i)->start) return 0;
+      if (*(long*)bkt(a,i)->data != *(long*)bkt(b,i)->data) return 0;
+    }
+  }
+  return 1;
+}
+
+void run(unsigned ntiers, const unsigned *nbs, const unsigned *spbs) {
+  time_t whens[100], now = 0;
+  long vals[100];
+  void *datas[100];
+  int i, j, n, ok = 1;
+  ts_t *a = ts_new_tiered(ntiers, nbs, spbs, &mm), *c;
+  ts_t *b = ts_new_tiered(ntiers, nbs, spbs, &mm);
+
+  for(i=0; i < 2000; i++) {
+    n = rnd(100);
+    for(j=0; j < n; j++) {
+      switch(rnd(20)) {
+        case 0: now += 5 + rnd(30); break;    // gap
+        case 1: now += 60 + rnd(200); break;  // gap past a window
+        default: now += rnd(3); break;
+      }
+      whens[j] = (rnd(10) == 0) ? now - rnd(120) : now; // stragglers
+      vals[j] = rnd(5);
+      datas[j] = &vals[j];
+      ts_add(a, whens[j], datas[j]);
+    }
+    ts_add_batch(b, whens, datas, n);
+    if (!same(a,b)) { printf("batch %d differs\n", i); ok = 0; break; }
+  }
+  printf("%s\n", ok ? "same" : "differ");
+  for(c = b; c; c = c->next) ts_show(c);
+  ts_free(a);
+  ts_free(b);
+}
+
+int main() {
+  /* samples 1, 3, 6 on {2x1s, 2x2s}: the coarse tier rotates
+   * part way through the batch */
+  unsigned nb2[] = {2,2}, spb2[] = {1,2};
+  time_t whens[] = {1,3,6};
+  long vals[] = {1,1,1};
+  void *datas[] = {&vals[0], &vals[1], &vals[2]};
+  ts_t *a = ts_new_tiered(2, nb2, spb2, &mm);
+  ts_t *b = ts_new_tiered(2, nb2, spb2, &mm);
+  for(int i=0; i < 3; i++) ts_add(a, whens[i], datas[i]);
+  ts_add_batch(b, whens, datas, 3);
+  printf("1,3,6: %s\n", same(a,b) ? "same" : "differ");
+  ts_free(a);
+  ts_free(b);
+
+  unsigned nb3[] = {10,6,4}, spb3[] = {1,5,30};
+  run(3, nb3, spb3);
+  return 0;
+}
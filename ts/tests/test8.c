@@ -0,0 +1,37 @@
+#include <stdio.h>
+#include <time.h>
+#include "ts.h"
+
+/* rotate by partial shifts until the oldest bucket has wrapped
+ * around the buffer several times, then by a full one */
+
+int dtors=0;
+void insert(long *cur, long *incr) { *cur += *incr; }
+void show(long *i) { printf("%lu\n", *i); }
+void dtor(long *i) { dtors++; }
+
+const ts_mm mm = {.sz=sizeof(long),
+                  .data=(ts_data_f*)insert,
+                  .dtor=(ts_dtor_f*)dtor,
+                  .show=(ts_show_f*)show };
+int main() {
+  time_t i=0;
+  long n;
+
+  ts_t *t = ts_new(4,10,&mm);
+  for(i=0; i < 40; i += 5) { n = i; ts_add(t, i, &n); }
+  ts_show(t);
+  ts_add(t,45,&n); ts_show(t);        // shift 1
+  ts_add(t,75,&n); ts_show(t);        // shift 3
+  for(i=80; i < 200; i += 10) { n = i; ts_add(t, i, &n); }
+  ts_show(t);
+  ts_add(t,150,&n); ts_show(t);       // too old
+  ts_add(t,175,&n); ts_show(t);       // in range
+  ts_add(t,223,&n); ts_show(t);       // shift 3
+  ts_add(t,1000,&n); ts_show(t);      // shift all
+  ts_add(t,1013,&n); ts_show(t);
+  printf("dtors %d\n", dtors);
+  ts_free(t);
+  printf("dtors %d\n", dtors);
+  return 0;
+}
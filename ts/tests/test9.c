@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include <time.h>
+#include "ts_typed.h"
+
+/* typed series: an int64 sum (same steps as test1), a double sum
+ * fed by add_n, and a struct with its own add op */
+
+typedef struct {
+  int32_t min, max, n;
+} mm_t;
+
+static inline void mm_add(mm_t *cur, mm_t v) {
+  if (!cur->n || v.min < cur->min) cur->min = v.min;
+  if (!cur->n || v.max > cur->max) cur->max = v.max;
+  cur->n += v.n;
+}
+
+TS_DEFINE(ts_mm, mm_t, mm_add)
+
+void show_i64(int64_t *i) { printf("%ld\n", (long)*i); }
+void show_dbl(double *d) { printf("%.2f\n", *d); }
+void show_mm(mm_t *m) { printf("%d..%d n=%d\n", m->min, m->max, m->n); }
+
+int main() {
+  time_t i=0;
+  double d[10] = {.5, .5, .5, .5, .5, 1, 1, 1, 1, 1};
+  mm_t m;
+
+  ts_i64_t *a = ts_i64_new(10,10); ts_i64_show(a, show_i64);
+  for(i=0; i < 100; i += 10) ts_i64_add(a, i, 1);
+  ts_i64_show(a, show_i64);
+  ts_i64_add(a,100,1); ts_i64_show(a, show_i64);
+  ts_i64_add(a,120,1); ts_i64_show(a, show_i64);
+  ts_i64_add(a,555,1); ts_i64_show(a, show_i64);
+  ts_i64_free(a);
+
+  ts_dbl_t *b = ts_dbl_new(3,60);
+  ts_dbl_add_n(b, 30, d, 10);
+  ts_dbl_add_n(b, 150, d, 5);
+  ts_dbl_add_n(b, 200, d+5, 5);
+  ts_dbl_add(b, 10, 100);       // too old
+  ts_dbl_show(b, show_dbl);
+  ts_dbl_free(b);
+
+  ts_mm_t *c = ts_mm_new(4,1);
+  for(i=0; i < 12; i++) {
+    m.min = m.max = (int32_t)(i * 7 % 5);
+    m.n = 1;
+    ts_mm_add(c, i / 2, m);
+  }
+  ts_mm_show(c, show_mm);
+  ts_mm_free(c);
+  return 0;
+}
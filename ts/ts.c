@@ -2,12 +2,123 @@
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
+#include <math.h>
 #include "ts.h"
 
 static void ts_def_clear(char *data, size_t sz) { memset(data,0,sz); }
 static void ts_def_incr(int *cur, int *incr) { *cur += (incr ? (*incr) : 1); }
 static void ts_def_show(int *cur) { printf("%d\n",*cur); }
 
+/*
+ * the index behind ts_query, kept by bucket position. bucket sums
+ * and sample counts are in fenwick trees, and min and max in 
+ * segment trees with m leaves, where a bucket with no samples is
+ * +inf for min and -inf for max. adding to a bucket only counts the
+ * sample and marks the bucket dirty; dirty buckets are re-read 
+ * with mm.value and pushed into the trees at the next query. so a
+ * bucket taking many samples between queries costs one update.
+ */
+struct ts_index {
+  unsigned m;
+  double *sum, *cnt;     // fenwick, 1-based
+  double *min, *max;     // segment trees, leaf p at m + p
+  double *val;           // bucket values as in the trees
+  unsigned long *n;      // samples per bucket
+  unsigned long *n_idx;  // samples per bucket as in the trees
+  unsigned *dirty;       // positions changed since the trees
+  char *is_dirty;
+  unsigned ndirty;
+};
+
+#define MIN(a,b) (((a) < (b)) ? (a) : (b))
+#define MAX(a,b) (((a) > (b)) ? (a) : (b))
+
+static void fen_add(double *f, unsigned nb, unsigned p, double d) {
+  for(p++; p <= nb; p += p & -p) f[p] += d;
+}
+
+// sum of positions [0,p)
+static double fen_sum(double *f, unsigned p) {
+  double s = 0;
+  for(; p; p -= p & -p) s += f[p];
+  return s;
+}
+
+static void seg_set(struct ts_index *x, unsigned p, double lo, double hi) {
+  unsigned i = x->m + p;
+  x->min[i] = lo;
+  x->max[i] = hi;
+  for(i /= 2; i; i /= 2) {
+    x->min[i] = MIN(x->min[2*i], x->min[2*i+1]);
+    x->max[i] = MAX(x->max[2*i], x->max[2*i+1]);
+  }
+}
+
+static void ts_touch(ts_t *t, unsigned p, unsigned long n) {
+  struct ts_index *x = t->idx;
+  x->n[p] += n;
+  if (x->is_dirty[p]) return;
+  x->is_dirty[p] = 1;
+  x->dirty[x->ndirty++] = p;
+}
+
+static void ts_index_free(struct ts_index *x) {
+  free(x->sum); free(x->cnt);
+  free(x->min); free(x->max);
+  free(x->val); free(x->n); free(x->n_idx);
+  free(x->dirty); free(x->is_dirty);
+  free(x);
+}
+
+// an empty index, with every bucket dirty so the first query reads them
+static struct ts_index *ts_index_new(unsigned nb) {
+  struct ts_index *x = calloc(1,sizeof(*x));
+  unsigned i;
+  if (!x) return NULL;
+  for(x->m = 1; x->m < nb; x->m *= 2) ;
+  x->sum = calloc(nb+1, sizeof(double));
+  x->cnt = calloc(nb+1, sizeof(double));
+  x->min = malloc(2 * x->m * sizeof(double));
+  x->max = malloc(2 * x->m * sizeof(double));
+  x->val = calloc(nb, sizeof(double));
+  x->n = calloc(nb, sizeof(unsigned long));
+  x->n_idx = calloc(nb, sizeof(unsigned long));
+  x->dirty = malloc(nb * sizeof(unsigned));
+  x->is_dirty = malloc(nb);
+  if (!x->sum || !x->cnt || !x->min || !x->max || !x->val || !x->n || 
+      !x->n_idx || !x->dirty || !x->is_dirty) {
+    ts_index_free(x);
+    return NULL;
+  }
+  for(i=0; i < 2 * x->m; i++) {
+    x->min[i] = INFINITY;
+    x->max[i] = -INFINITY;
+  }
+  for(i=0; i < nb; i++) x->dirty[i] = i;
+  memset(x->is_dirty, 1, nb);
+  x->ndirty = nb;
+  return x;
+}
+
+static void ts_index_flush(ts_t *t) {
+  struct ts_index *x = t->idx;
+  unsigned i, p;
+  double v;
+  for(i=0; i < x->ndirty; i++) {
+    p = x->dirty[i];
+    v = t->mm.value(bkt_at(t,p)->data);
+    fen_add(x->sum, t->num_buckets, p, v - x->val[p]);
+    fen_add(x->cnt, t->num_buckets, p, (double)x->n[p] - x->n_idx[p]);
+    // a bucket with no samples has no value to take a min or max of
+    if (x->n[p]) seg_set(x, p, v, v);
+    else seg_set(x, p, INFINITY, -INFINITY);
+    x->val[p] = v;
+    x->n_idx[p] = x->n[p];
+    x->is_dirty[p] = 0;
+  }
+  x->ndirty = 0;
+}
+
 ts_t *ts_new(unsigned num_buckets, unsigned secs_per_bucket, const ts_mm *mm) {
   int i;
   ts_t *t = calloc(1,sizeof(ts_t)); if (!t) return NULL;
@@ -27,8 +138,14 @@ ts_t *ts_new(unsigned num_buckets, unsigned secs_per_bucket, const ts_mm *mm) {
   if (t->mm.show == NULL) {
      if (mm->sz == sizeof(int)) t->mm.show = (ts_show_f*)ts_def_show;
   }
+  if (t->mm.merge == NULL) t->mm.merge = t->mm.data;
   t->buckets = calloc(num_buckets,sizeof(ts_bucket)+t->mm.sz);
   if (t->buckets == NULL) { free(t); return NULL; }
+  if (t->mm.value && ((t->idx = ts_index_new(num_buckets)) == NULL)) {
+    free(t->buckets);
+    free(t);
+    return NULL;
+  }
   for(i=0; i<t->num_buckets; i++) {
     //fprintf(stderr,"t->buckets %p bkt(t,%d) %p\n", t->buckets, i, bkt(t,i));
     bkt(t,i)->start = i * t->secs_per_bucket;
@@ -37,40 +154,153 @@ ts_t *ts_new(unsigned num_buckets, unsigned secs_per_bucket, const ts_mm *mm) {
   return t;
 }
 
-void ts_add(ts_t *t, time_t when, void *data) {
+ts_t *ts_new_tiered(unsigned ntiers, const unsigned *num_buckets, 
+                    const unsigned *secs_per_bucket, const ts_mm *mm) {
+  ts_t *t = NULL, *c;
   int i;
-  if (bkt(t,0)->start > when) return; // too old
-  /* figure out bucket it should go in */
-  unsigned idx = (when - bkt(t,0)->start) / t->secs_per_bucket;
-  if (idx >= t->num_buckets) { // shift
-    unsigned shift = (idx - t->num_buckets) + 1;
-    if (shift > t->num_buckets) shift = t->num_buckets;
-    if (shift <= t->num_buckets) {
-      if (t->mm.dtor) {
-        for(i=0; i<shift; i++) t->mm.dtor(bkt(t,i)->data);
-      }
+  for(i=ntiers-1; i >= 0; i--) {  // coarsest first
+    if ((i+1 < ntiers) && (secs_per_bucket[i+1] % secs_per_bucket[i])) 
+      goto fail;
+    if ( (c = ts_new(num_buckets[i], secs_per_bucket[i], mm)) == NULL) 
+      goto fail;
+    c->next = t;
+    t = c;
+  }
+  return t;
+
+ fail:
+  if (t) ts_free(t);
+  return NULL;
+}
+
+static void ts_fold(ts_t *t, time_t when, void *data, int merge, 
+                    unsigned long n);
+
+/* clear the bucket at position p for reuse, merging it into the 
+ * next tier first */
+static void ts_expire(ts_t *t, unsigned p) {
+  ts_bucket *b = bkt_at(t,p);
+  unsigned long n = t->idx ? t->idx->n[p] : 0;
+  if (t->next) ts_fold(t->next, b->start, b->data, 1, n);
+  if (t->mm.dtor) t->mm.dtor(b->data);
+  t->mm.ctor(b->data,t->mm.sz);
+  if (t->idx) {
+    t->idx->n[p] = 0;
+    ts_touch(t, p, 0);
+  }
+}
+
+/* expire the oldest shift buckets and reuse them as the newest.
+ * only those buckets are touched; the others keep their place in
+ * the ring. if all of them expire, the series restarts at when. */
+static void ts_rotate(ts_t *t, time_t shift, time_t when) {
+  unsigned i, p, n = t->num_buckets;
+  if (shift >= n) {
+    for(i=0; i<n; i++) {
+      p = (t->head + i) % n;
+      ts_expire(t, p);
+      bkt_at(t,p)->start = when + (time_t)i * t->secs_per_bucket;
     }
-    if (shift < t->num_buckets) {
-      memmove(bkt(t,0),bkt(t,shift),(t->num_buckets-shift)*(sizeof(ts_bucket)+t->mm.sz));
+    t->base = when;
+    return;
+  }
+  for(i=0; i<shift; i++) {
+    p = (t->head + i) % n;
+    ts_expire(t, p);
+    bkt_at(t,p)->start = t->base + (time_t)(n + i) * t->secs_per_bucket;
+  }
+  t->head = (t->head + shift) % n;
+  t->base += shift * t->secs_per_bucket;
+}
+
+/* add a sample (merge == 0) or a finer tier's bucket of n samples
+ * (merge == 1) */
+static void ts_fold(ts_t *t, time_t when, void *data, int merge, 
+                    unsigned long n) {
+  time_t idx;
+  unsigned p;
+  if (t->base > when) { // too old
+    if (t->next) ts_fold(t->next, when, data, merge, n);
+    return;
+  }
+  /* figure out bucket it should go in */
+  idx = (when - t->base) / t->secs_per_bucket;
+  if (idx >= t->num_buckets) {
+    ts_rotate(t, (idx - t->num_buckets) + 1, when);
+    idx = (when - t->base) / t->secs_per_bucket;
+    assert(idx < t->num_buckets);
+  }
+  p = t->head + idx;
+  if (p >= t->num_buckets) p -= t->num_buckets;
+  if (merge) t->mm.merge(bkt_at(t,p)->data,data);
+  else t->mm.data(bkt_at(t,p)->data,data);
+  if (t->idx) ts_touch(t, p, n);
+}
+
+void ts_add(ts_t *t, time_t when, void *data) {
+  ts_fold(t, when, data, 0, 1);
+}
+
+/* n samples, datas[i] at whens[i] (datas may be NULL, to pass NULL
+ * for each). the outcome is as if each went through ts_add in turn.
+ * on a single tier the buckets rotate at most once: a first pass 
+ * over the times works out where the window ends up, without 
+ * touching a bucket, then the samples go in. with coarser tiers,
+ * rotating up front would hand them expired buckets and too-old
+ * samples in another order than ts_add does, so there a sample 
+ * that moves the window goes through ts_add at its place in the
+ * batch. a run of samples in the same bucket, as in-order input 
+ * mostly is, goes in without redoing the arithmetic */
+void ts_add_batch(ts_t *t, const time_t *whens, void **datas, size_t n) {
+  unsigned nb = t->num_buckets, spb = t->secs_per_bucket, p;
+  time_t base = t->base, end = base + (time_t)nb * spb, idx, lo, hi;
+  int restart = 0;
+  size_t i, j;
+  char *cur;
+
+  for(i=0; (i<n) && !t->next; i++) {
+    if (whens[i] < end) continue;  // in the window, or too old
+    idx = (whens[i] - base) / spb;
+    if ((idx - nb) + 1 >= nb) {
+      base = whens[i];
+      restart = 1;
+    } else base += ((idx - nb) + 1) * spb;
+    end = base + (time_t)nb * spb;
+  }
+  if (restart) ts_rotate(t, nb, base);
+  else if (base > t->base) ts_rotate(t, (base - t->base) / spb, base);
+
+  for(i=0; i<n; ) {
+    if (whens[i] < t->base) { // too old
+      if (t->next) ts_fold(t->next, whens[i], datas ? datas[i] : NULL, 0, 1);
+      i++;
+      continue;
     }
-    if (shift) {
-      for(i=t->num_buckets-shift; i<t->num_buckets; i++) { 
-        t->mm.ctor(bkt(t,i)->data,t->mm.sz);
-        bkt(t,i)->start = (i > 0) ? (bkt(t,i-1)->start + t->secs_per_bucket) : when;
-      }
+    idx = (whens[i] - t->base) / spb;
+    if (idx >= nb) { // tiered: rotate here, cascading as ts_add does
+      ts_fold(t, whens[i], datas ? datas[i] : NULL, 0, 1);
+      i++;
+      continue;
     }
-    idx = (when - bkt(t,0)->start) / t->secs_per_bucket;
-    assert(idx < t->num_buckets);
+    p = t->head + idx;
+    if (p >= nb) p -= nb;
+    cur = bkt_at(t,p)->data;
+    lo = t->base + idx * spb;
+    hi = lo + spb;
+    j = i;
+    do t->mm.data(cur, datas ? datas[i] : NULL);
+    while ((++i < n) && (whens[i] >= lo) && (whens[i] < hi));
+    if (t->idx) ts_touch(t, p, i - j);
   }
-  void *cur = bkt(t,idx)->data;
-  t->mm.data(cur,data);
 }
 
 void ts_free(ts_t *t) {
   int i;
+  if (t->next) ts_free(t->next);
   if (t->mm.dtor) {
-    for(i=0; i<t->num_buckets; i++) t->mm.dtor(bkt(t,i)->data);
+    for(i=0; i<t->num_buckets; i++) t->mm.dtor(bkt_at(t,i)->data);
   }
+  if (t->idx) ts_index_free(t->idx);
   free(t->buckets);
   free(t);
 }
@@ -84,3 +314,59 @@ void ts_show(ts_t *t) {
   }
   printf("\n");
 }
+
+typedef struct {
+  double sum, cnt, min, max;
+} ts_agg;
+
+// aggregate positions [p0,p1] of t's index
+static void ts_agg_range(ts_t *t, unsigned p0, unsigned p1, ts_agg *a) {
+  struct ts_index *x = t->idx;
+  unsigned l = x->m + p0, r = x->m + p1 + 1;
+  a->sum += fen_sum(x->sum, p1+1) - fen_sum(x->sum, p0);
+  a->cnt += fen_sum(x->cnt, p1+1) - fen_sum(x->cnt, p0);
+  for(; l < r; l /= 2, r /= 2) {
+    if (l & 1) {
+      a->min = MIN(a->min, x->min[l]);
+      a->max = MAX(a->max, x->max[l]);
+      l++;
+    }
+    if (r & 1) {
+      r--;
+      a->min = MIN(a->min, x->min[r]);
+      a->max = MAX(a->max, x->max[r]);
+    }
+  }
+}
+
+double ts_query(ts_t *t, time_t from, time_t to, int agg) {
+  ts_agg a = {0, 0, INFINITY, -INFINITY};
+  time_t i0, i1, nb;
+  unsigned p0, p1;
+
+  if (!t->idx) return NAN;
+  for(; t; t = t->next) {
+    nb = t->num_buckets;
+    if ((to <= t->base) || (to <= from)) continue;
+    i0 = (from > t->base) ? (from - t->base) / t->secs_per_bucket : 0;
+    i1 = (to - 1 - t->base) / t->secs_per_bucket;
+    if (i1 >= nb) i1 = nb - 1;
+    if (i0 > i1) continue;
+    ts_index_flush(t);
+    p0 = (t->head + i0) % nb;
+    p1 = (t->head + i1) % nb;
+    if (p0 <= p1) ts_agg_range(t, p0, p1, &a);
+    else {
+      ts_agg_range(t, p0, nb - 1, &a);
+      ts_agg_range(t, 0, p1, &a);
+    }
+  }
+  switch(agg) {
+    case TS_AGG_SUM: return a.sum;
+    case TS_AGG_COUNT: return a.cnt;
+    case TS_AGG_MIN: return (a.min == INFINITY) ? NAN : a.min;
+    case TS_AGG_MAX: return (a.max == -INFINITY) ? NAN : a.max;
+    case TS_AGG_MEAN: return a.cnt ? a.sum / a.cnt : NAN;
+  }
+  return NAN;
+}
@@ -3,12 +3,15 @@ typedef void (ts_data_f)(char *cur, char *add);
 typedef void (ts_ctor_f)(void *elt, size_t sz);
 typedef void (ts_dtor_f)(void *elt);
 typedef void (ts_show_f)(void *elt);
+typedef double (ts_value_f)(void *elt);
 typedef struct {
     size_t sz;
     ts_data_f *data;
     ts_ctor_f *ctor;
     ts_dtor_f *dtor;
     ts_show_f *show;
+    ts_data_f *merge; /* fold a bucket into a coarser one; default data */
+    ts_value_f *value; /* a bucket as a number; enables ts_query */
 } ts_mm;
 
 typedef struct {
@@ -16,16 +19,46 @@ typedef struct {
   char data[]; /* C99 flexible array member */
 } ts_bucket;
 
-#define bkt(t,i) ((ts_bucket*)((char*)((t)->buckets) + ((i)*(sizeof(ts_bucket)+(t)->mm.sz))))
-typedef struct {
+/* the buckets are a ring. bkt(t,i) is the i'th bucket oldest first, 
+ * which is bkt_at(t,p) for p = (head + i) % num_buckets */
+#define bkt_at(t,p) ((ts_bucket*)((char*)((t)->buckets) + ((p)*(sizeof(ts_bucket)+(t)->mm.sz))))
+#define bkt(t,i) bkt_at(t, ((t)->head + (i)) % (t)->num_buckets)
+typedef struct ts_t {
   ts_mm mm;
   unsigned secs_per_bucket;
   unsigned num_buckets;
+  unsigned head;  /* position of the oldest bucket */
+  time_t base;    /* its start time */
   ts_bucket *buckets;
+  struct ts_t *next; /* coarser tier, or NULL */
+  struct ts_index *idx; /* for ts_query, if mm.value is set */
 } ts_t;
 
 ts_t *ts_new(unsigned num_buckets, unsigned secs_per_bucket, const ts_mm *mm);
+/* tiers: ts_new_tiered builds ntiers series, finest first, each 
+ * tier's secs_per_bucket a multiple of the one before. the finest
+ * is returned and the rest follow through next. buckets expiring
+ * from a tier are merged into the next, and samples too old for a
+ * tier go straight to the next, so memory stays fixed while old 
+ * data is kept at coarser resolution. */
+ts_t *ts_new_tiered(unsigned ntiers, const unsigned *num_buckets, 
+                    const unsigned *secs_per_bucket, const ts_mm *mm);
 void ts_add(ts_t *t, time_t when, void *data);
+void ts_add_batch(ts_t *t, const time_t *whens, void **datas, size_t n);
 void ts_free(ts_t *t);
 void ts_show(ts_t *t);
 
+/* range queries, over the buckets overlapping [from,to) in t and 
+ * its coarser tiers. a bucket's value is mm.value of it; count is
+ * the number of samples added to the buckets, and mean is sum over
+ * count. min and max are of the values of buckets that got 
+ * samples, each at its own tier's resolution. NAN if the range has
+ * no samples (0 for sum and count) or the series has no mm.value.
+ * each tier answers in O(log n). */
+#define TS_AGG_SUM   0
+#define TS_AGG_MIN   1
+#define TS_AGG_MAX   2
+#define TS_AGG_COUNT 3
+#define TS_AGG_MEAN  4
+double ts_query(ts_t *t, time_t from, time_t to, int agg);
+
@@ -0,0 +1,124 @@
+#ifndef TS_TYPED_H
+#define TS_TYPED_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+/* typed time series. TS_DEFINE(name, type, add_op) generates a
+ * name##_t for one fixed-size payload type, and its functions as
+ * static inlines, so the accumulate step is compiled in where ts_t
+ * calls through mm.data:
+ *
+ *   TS_DEFINE(ts_lat, lat_t, lat_add)
+ *
+ *   ts_lat_t *t = ts_lat_new(60, 1);
+ *   ts_lat_add(t, when, sample);
+ *   ts_lat_free(t);
+ *
+ * add_op(cur, v) folds the value v into *cur. it may be a macro or
+ * an inline function. buckets start out zeroed and the payload has
+ * no destructor. the payloads are one plain array, oldest bucket at
+ * head, and bucket start times are worked out from base rather than
+ * stored, so bucket i is a type* like any other. rotation follows
+ * ts_add: expired buckets are reused as the newest, and a jump past
+ * the whole window restarts the series at the new time.
+ *
+ * ts_i64 and ts_dbl (sums of int64_t and double) are defined below.
+ */
+
+#define TS_SUM(cur, v) (*(cur) += (v))
+
+#define TS_DEFINE(name, type, add_op)                                        \
+typedef struct {                                                             \
+  unsigned secs_per_bucket;                                                  \
+  unsigned num_buckets;                                                      \
+  unsigned head;  /* position of the oldest bucket */                        \
+  time_t base;    /* its start time */                                       \
+  type *data;                                                                \
+} name##_t;                                                                  \
+                                                                             \
+static inline name##_t *name##_new(unsigned num_buckets,                     \
+                                   unsigned secs_per_bucket) {               \
+  name##_t *t = calloc(1, sizeof(name##_t));                                 \
+  if (!t) return NULL;                                                       \
+  t->secs_per_bucket = secs_per_bucket;                                      \
+  t->num_buckets = num_buckets;                                              \
+  t->data = calloc(num_buckets, sizeof(type));                               \
+  if (t->data == NULL) { free(t); return NULL; }                             \
+  return t;                                                                  \
+}                                                                            \
+                                                                             \
+static inline void name##_free(name##_t *t) {                                \
+  free(t->data);                                                             \
+  free(t);                                                                   \
+}                                                                            \
+                                                                             \
+/* the i'th bucket oldest first, and its start time */                       \
+static inline type *name##_bkt(name##_t *t, unsigned i) {                    \
+  unsigned p = t->head + i;                                                  \
+  if (p >= t->num_buckets) p -= t->num_buckets;                              \
+  return &t->data[p];                                                        \
+}                                                                            \
+                                                                             \
+static inline time_t name##_start(name##_t *t, unsigned i) {                 \
+  return t->base + (time_t)i * t->secs_per_bucket;                           \
+}                                                                            \
+                                                                             \
+static inline void name##_rotate(name##_t *t, time_t shift, time_t when) {   \
+  unsigned i, n = t->num_buckets;                                            \
+  if (shift >= n) {                                                          \
+    memset(t->data, 0, n * sizeof(type));                                    \
+    t->base = when;                                                          \
+    return;                                                                  \
+  }                                                                          \
+  for(i=0; i < shift; i++) memset(name##_bkt(t,i), 0, sizeof(type));         \
+  t->head = (t->head + shift) % n;                                           \
+  t->base += shift * t->secs_per_bucket;                                     \
+}                                                                            \
+                                                                             \
+/* the bucket for when, rotating if need be. NULL if too old */              \
+static inline type *name##_at(name##_t *t, time_t when) {                    \
+  time_t idx;                                                                \
+  if (t->base > when) return NULL;                                           \
+  idx = (when - t->base) / t->secs_per_bucket;                               \
+  if (idx >= t->num_buckets) {                                               \
+    name##_rotate(t, (idx - t->num_buckets) + 1, when);                      \
+    idx = (when - t->base) / t->secs_per_bucket;                             \
+  }                                                                          \
+  return name##_bkt(t, idx);                                                 \
+}                                                                            \
+                                                                             \
+static inline void name##_add(name##_t *t, time_t when, type v) {            \
+  type *cur = name##_at(t, when);                                            \
+  if (cur) add_op(cur, v);                                                   \
+}                                                                            \
+                                                                             \
+/* n values with the same time. they are folded into a local, which          \
+ * the compiler can keep in registers and vectorize for simple ops */        \
+static inline void name##_add_n(name##_t *t, time_t when,                    \
+                                const type *v, size_t n) {                   \
+  type *cur = name##_at(t, when), acc;                                       \
+  size_t i;                                                                  \
+  if (!cur) return;                                                          \
+  acc = *cur;                                                                \
+  for(i=0; i < n; i++) add_op(&acc, v[i]);                                   \
+  *cur = acc;                                                                \
+}                                                                            \
+                                                                             \
+static inline void name##_show(name##_t *t, void (*show)(type *)) {          \
+  unsigned i;                                                                \
+  for(i=0; i < t->num_buckets; i++) {                                        \
+    printf("#%u(%ld): ", i, (long)name##_start(t,i));                        \
+    if (show) show(name##_bkt(t,i));                                         \
+    else printf("\n");                                                       \
+  }                                                                          \
+  printf("\n");                                                              \
+}
+
+TS_DEFINE(ts_i64, int64_t, TS_SUM)
+TS_DEFINE(ts_dbl, double, TS_SUM)
+
+#endif /* TS_TYPED_H */